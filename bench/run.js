@@ -0,0 +1,219 @@
+#!/usr/bin/env node
+'use strict';
+
+// End-to-end benchmarks through the public JS API.
+//
+// Measures what users see: CSV ingest, plan serialization, the N-API hop
+// and result wrapping on top of the engine work covered by teide_bench.
+// Every case runs in its own child process so the reported peak RSS
+// belongs to that case alone.
+//
+//   npm run build && node bench/run.js [--rows N] [--k K] [--reps R]
+//                                      [--case substr] [--json]
+
+const { fork } = require('child_process');
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+
+function parseArgs(argv) {
+    const opts = { rows: 1e6, k: 100, reps: 5, case: '', json: false, child: null, dir: null };
+    for (let i = 0; i < argv.length; i++) {
+        const a = argv[i];
+        if (a === '--json') opts.json = true;
+        else if (a === '--rows') opts.rows = Number(argv[++i]);
+        else if (a === '--k') opts.k = Number(argv[++i]);
+        else if (a === '--reps') opts.reps = Number(argv[++i]);
+        else if (a === '--case') opts.case = argv[++i];
+        else if (a === '--child') opts.child = argv[++i];
+        else if (a === '--dir') opts.dir = argv[++i];
+        else throw new Error(`unknown argument ${a}`);
+    }
+    return opts;
+}
+
+// ---------------------------------------------------------------------------
+// Deterministic data (same shapes as bench/teide_bench.c)
+// ---------------------------------------------------------------------------
+
+// mulberry32: fast, seedable and plenty for synthetic data
+function rng(seed) {
+    let s = seed >>> 0;
+    return () => {
+        s = (s + 0x6d2b79f5) >>> 0;
+        let z = s;
+        z = Math.imul(z ^ (z >>> 15), z | 1);
+        z ^= z + Math.imul(z ^ (z >>> 7), z | 61);
+        return ((z ^ (z >>> 14)) >>> 0) / 4294967296;
+    };
+}
+
+function writeCsv(file, header, n, row) {
+    const fd = fs.openSync(file + '.tmp', 'w');
+    fs.writeSync(fd, header + '\n');
+    let buf = [];
+    for (let i = 0; i < n; i++) {
+        buf.push(row());
+        if (buf.length === 65536) {
+            fs.writeSync(fd, buf.join('\n') + '\n');
+            buf = [];
+        }
+    }
+    if (buf.length) fs.writeSync(fd, buf.join('\n') + '\n');
+    fs.closeSync(fd);
+    fs.renameSync(file + '.tmp', file);
+}
+
+function genData(dir, n, k) {
+    fs.mkdirSync(dir, { recursive: true });
+    const h2o = path.join(dir, 'h2o.csv');
+    const lineitem = path.join(dir, 'lineitem.csv');
+    const nk = Math.max(1, Math.floor(n / k));
+    const pad = (v, w) => String(v).padStart(w, '0');
+
+    if (!fs.existsSync(h2o)) {
+        const r = rng(0x7e1de5ed);
+        const int = (lo, hi) => lo + Math.floor(r() * (hi - lo + 1));
+        writeCsv(h2o, 'id1,id2,id3,id4,id5,id6,v1,v2,v3', n, () =>
+            `id${pad(int(1, k), 3)},id${pad(int(1, k), 3)},id${pad(int(1, nk), 10)},` +
+            `${int(1, k)},${int(1, k)},${int(1, nk)},${int(1, 5)},${int(1, 15)},` +
+            `${(r() * 100).toFixed(6)}`);
+    }
+    if (!fs.existsSync(lineitem)) {
+        const r = rng(0x11e17e);
+        const int = (lo, hi) => lo + Math.floor(r() * (hi - lo + 1));
+        const flags = ['A', 'N', 'R'];
+        const status = ['F', 'O'];
+        writeCsv(lineitem,
+            'l_orderkey,l_quantity,l_extendedprice,l_discount,l_tax,l_returnflag,l_linestatus',
+            n, () =>
+                `${int(1, Math.max(1, n >> 2))},${int(1, 50)},${(900 + r() * 104100).toFixed(2)},` +
+                `${(r() * 0.1).toFixed(2)},${(r() * 0.08).toFixed(2)},` +
+                `${flags[int(0, 2)]},${status[int(0, 1)]}`);
+    }
+    return { h2o, lineitem };
+}
+
+// ---------------------------------------------------------------------------
+// Cases: (df, lib) => Promise<Table> | Table. `table` names the input whose
+// row count is used for rows/s.
+// ---------------------------------------------------------------------------
+
+const CASES = [
+    { name: 'csv-read', table: 'lineitem', ingest: true,
+      run: (ctx, files) => ctx.readCsvSync(files.lineitem) },
+    { name: 'groupby-low', table: 'h2o',
+      run: (df, { col }) => df.groupBy('id1').agg(col('v1').sum()).collectSync() },
+    { name: 'groupby-high', table: 'h2o',
+      run: (df, { col }) => df.groupBy('id3').agg(col('v1').sum(), col('v3').mean()).collectSync() },
+    { name: 'groupby-multi', table: 'h2o',
+      run: (df, { col }) => df.groupBy('id4', 'id5')
+          .agg(col('v1').sum(), col('v2').sum(), col('v3').sum()).collectSync() },
+    { name: 'groupby-bucket', table: 'lineitem',
+      run: (df, { col, timeBucket }) => df.groupBy(timeBucket('l_orderkey', 1000))
+          .agg(col('l_quantity').sum(), col('l_extendedprice').max()).collectSync() },
+    { name: 'filter-groupby', table: 'lineitem',
+      run: (df, { col }) => df.filter(col('l_quantity').lt(24).and(col('l_discount').ge(0.05)))
+          .groupBy('l_returnflag', 'l_linestatus')
+          .agg(col('l_quantity').sum(), col('l_extendedprice').sum(), col('l_discount').mean())
+          .collectSync() },
+    { name: 'filter', table: 'h2o',
+      run: (df, { col }) => df.filter(col('v3').gt(90)).collectSync() },
+    { name: 'sort', table: 'h2o',
+      run: (df) => df.sort('v3').collectSync() },
+    { name: 'topn', table: 'h2o',
+      run: (df) => df.sort('v3', { descending: true }).head(100).collectSync() },
+    { name: 'groupby-async', table: 'h2o',
+      run: (df, { col }) => df.groupBy('id1').agg(col('v1').sum()).collect() },
+    // Fixed per-call cost: 1000 tiny queries, so the time is mostly the hop
+    { name: 'micro-sync-1k', table: 'h2o',
+      run: (df, { col }) => {
+          let t;
+          for (let i = 0; i < 1000; i++)
+              t = df.filter(col('v1').gt(i % 5)).head(10).collectSync({ cache: false });
+          return t;
+      } },
+];
+
+// ---------------------------------------------------------------------------
+// Child: run one case and report JSON to the parent
+// ---------------------------------------------------------------------------
+
+async function runChild(opts) {
+    const lib = require(path.join(__dirname, '..', 'dist'));
+    const files = genData(opts.dir, opts.rows, opts.k);
+    const bc = CASES.find((c) => c.name === opts.child);
+    const ctx = new lib.Context();
+    try {
+        const input = ctx.readCsvSync(files[bc.table]);
+        const rows = input.nRows;
+        const call = bc.ingest ? () => bc.run(ctx, files) : () => bc.run(input, lib);
+
+        const warm = await call();
+        const outRows = warm.nRows;
+        const samples = [];
+        for (let i = 0; i < opts.reps; i++) {
+            const t0 = process.hrtime.bigint();
+            await call();
+            samples.push(Number(process.hrtime.bigint() - t0) / 1e6);
+        }
+        samples.sort((a, b) => a - b);
+        process.send({
+            case: bc.name,
+            rows,
+            outRows,
+            bestMs: samples[0],
+            medianMs: samples[samples.length >> 1],
+            peakRssBytes: process.resourceUsage().maxRSS * 1024,
+        });
+    } finally {
+        ctx.destroy();
+    }
+}
+
+function runCase(name, opts) {
+    return new Promise((resolve, reject) => {
+        const args = ['--child', name, '--dir', opts.dir, '--rows', String(opts.rows),
+                      '--k', String(opts.k), '--reps', String(opts.reps)];
+        const child = fork(__filename, args, { stdio: ['ignore', 'inherit', 'inherit', 'ipc'] });
+        let result = null;
+        child.on('message', (m) => { result = m; });
+        child.on('error', reject);
+        child.on('exit', (code) => {
+            if (code === 0 && result) resolve(result);
+            else reject(new Error(`case ${name} exited with code ${code}`));
+        });
+    });
+}
+
+async function main() {
+    const opts = parseArgs(process.argv.slice(2));
+    opts.dir = opts.dir || path.join(os.tmpdir(), `teide-bench-${opts.rows}-${opts.k}`);
+    if (opts.child) return runChild(opts);
+
+    genData(opts.dir, opts.rows, opts.k);
+    const results = [];
+    if (!opts.json) {
+        console.log(`teide bench (js): rows=${opts.rows} k=${opts.k} reps=${opts.reps} ` +
+                    `cpus=${os.cpus().length}\n`);
+        console.log('case             out rows    best ms  median ms    Mrows/s   peak RSS');
+    }
+    for (const bc of CASES) {
+        if (opts.case && !bc.name.includes(opts.case)) continue;
+        const r = await runCase(bc.name, opts);
+        r.rowsPerSec = r.rows / (r.bestMs / 1e3);
+        results.push(r);
+        if (!opts.json) {
+            console.log(`${r.case.padEnd(16)} ${String(r.outRows).padStart(8)} ` +
+                        `${r.bestMs.toFixed(2).padStart(10)} ${r.medianMs.toFixed(2).padStart(10)} ` +
+                        `${(r.rowsPerSec / 1e6).toFixed(2).padStart(10)} ` +
+                        `${(r.peakRssBytes / 2 ** 20).toFixed(0).padStart(8)}MB`);
+        }
+    }
+    if (opts.json) console.log(JSON.stringify(results, null, 2));
+}
+
+main().catch((e) => {
+    console.error(e);
+    process.exit(1);
+});
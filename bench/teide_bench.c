@@ -0,0 +1,798 @@
+/*
+ *   Copyright (c) 2024-2026 Anton Kundenko <singaraiona@gmail.com>
+ *   All rights reserved.
+
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy
+ *   of this software and associated documentation files (the "Software"), to deal
+ *   in the Software without restriction, including without limitation the rights
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *   copies of the Software, and to permit persons to whom the Software is
+ *   furnished to do so, subject to the following conditions:
+
+ *   The above copyright notice and this permission notice shall be included in all
+ *   copies or substantial portions of the Software.
+
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *   SOFTWARE.
+ */
+
+/*
+ * teide_bench — reproducible engine benchmarks.
+ *
+ * Generates synthetic tables in the shape of the h2o.ai db-benchmark
+ * (groupby / join) and TPC-H lineitem from a fixed seed, runs each case
+ * `reps` times for every requested thread count, and prints the best and
+ * median wall time, input rows/s, peak RSS and speedup over the first
+ * thread count.
+ *
+ *   teide_bench [-n rows] [-k groups] [-r reps] [-t 1,2,4,...] [-c case]
+ *               [-d tmpdir] [--csv] [--pin]
+ *
+ * `--csv` prints machine-readable lines instead of the table, for diffing
+ * runs across versions. `--pin` pins pool threads to CPUs and binds worker
+ * heaps to their NUMA node.
+ */
+
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <teide/td.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+/* --------------------------------------------------------------------------
+ * Options
+ * -------------------------------------------------------------------------- */
+
+#define MAX_THREAD_COUNTS 16
+
+typedef struct {
+    int64_t     n_rows;
+    int64_t     k;               /* h2o "K": low-cardinality group count */
+    int         reps;
+    uint32_t    threads[MAX_THREAD_COUNTS];
+    int         n_threads;
+    const char* only;            /* substring filter on case names */
+    const char* tmpdir;
+    bool        csv_out;
+    bool        pin;
+} bench_opts_t;
+
+static void usage(const char* argv0) {
+    fprintf(stderr,
+        "usage: %s [-n rows] [-k groups] [-r reps] [-t 1,2,4] [-c case]\n"
+        "          [-d tmpdir] [--csv] [--pin]\n", argv0);
+}
+
+static int parse_threads(bench_opts_t* o, const char* s) {
+    o->n_threads = 0;
+    while (*s && o->n_threads < MAX_THREAD_COUNTS) {
+        char* end;
+        long v = strtol(s, &end, 10);
+        if (end == s || v < 1) return -1;
+        o->threads[o->n_threads++] = (uint32_t)v;
+        s = (*end == ',') ? end + 1 : end;
+    }
+    return o->n_threads > 0 ? 0 : -1;
+}
+
+/* --------------------------------------------------------------------------
+ * Measurement helpers
+ * -------------------------------------------------------------------------- */
+
+/* Reset the kernel's RSS high-water mark so each case reports its own
+ * peak. Linux only; elsewhere the peak is process-wide and monotonic. */
+static void rss_reset_peak(void) {
+#if defined(__linux__)
+    FILE* f = fopen("/proc/self/clear_refs", "w");
+    if (f) { fputs("5", f); fclose(f); }
+#endif
+}
+
+static int64_t rss_peak_bytes(void) {
+#if defined(__linux__)
+    FILE* f = fopen("/proc/self/status", "r");
+    if (f) {
+        char line[256];
+        while (fgets(line, sizeof(line), f)) {
+            long kb;
+            if (sscanf(line, "VmHWM: %ld kB", &kb) == 1) {
+                fclose(f);
+                return (int64_t)kb * 1024;
+            }
+        }
+        fclose(f);
+    }
+#endif
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+        return (int64_t)pmc.PeakWorkingSetSize;
+    return 0;
+#else
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+#if defined(__APPLE__)
+    return (int64_t)ru.ru_maxrss;          /* bytes on macOS */
+#else
+    return (int64_t)ru.ru_maxrss * 1024;   /* kB elsewhere */
+#endif
+#endif
+}
+
+static int64_t result_rows(td_t* r) {
+    if (r->type == TD_TABLE) return td_table_nrows(r);
+    return r->type > 0 ? r->len : 1;
+}
+
+static int cmp_i64(const void* a, const void* b) {
+    int64_t x = *(const int64_t*)a, y = *(const int64_t*)b;
+    return (x > y) - (x < y);
+}
+
+/* --------------------------------------------------------------------------
+ * Deterministic data generation
+ * -------------------------------------------------------------------------- */
+
+static uint64_t g_rng = 0x7e1de5eedULL;
+
+static inline uint64_t rng_next(void) {
+    uint64_t z = (g_rng += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/* Uniform in [lo, hi] */
+static inline int64_t rng_range(int64_t lo, int64_t hi) {
+    return lo + (int64_t)(rng_next() % (uint64_t)(hi - lo + 1));
+}
+
+static inline double rng_unit(void) {
+    return (double)(rng_next() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static td_t* gen_vec(int8_t type, int64_t n) {
+    td_t* v = td_vec_new(type, n);
+    if (!v || TD_IS_ERR(v)) return NULL;
+    v->len = n;
+    return v;
+}
+
+/* SYM column whose values are `fmt` formatted with ids in [1, card]. */
+static td_t* gen_sym(const char* fmt, int64_t card, int64_t n) {
+    int64_t* ids = (int64_t*)malloc((size_t)card * sizeof(int64_t));
+    if (!ids) return NULL;
+    char buf[32];
+    for (int64_t i = 0; i < card; i++) {
+        int len = snprintf(buf, sizeof(buf), fmt, (long long)(i + 1));
+        ids[i] = td_sym_intern(buf, (size_t)len);
+    }
+    td_t* v = td_sym_vec_new(TD_SYM_W32, n);
+    if (!v || TD_IS_ERR(v)) { free(ids); return NULL; }
+    v->len = n;
+    uint32_t* d = (uint32_t*)td_data(v);
+    for (int64_t i = 0; i < n; i++) d[i] = (uint32_t)ids[rng_range(0, card - 1)];
+    free(ids);
+    return v;
+}
+
+static td_t* gen_i64(int64_t lo, int64_t hi, int64_t n) {
+    td_t* v = gen_vec(TD_I64, n);
+    if (!v) return NULL;
+    int64_t* d = (int64_t*)td_data(v);
+    for (int64_t i = 0; i < n; i++) d[i] = rng_range(lo, hi);
+    return v;
+}
+
+static td_t* gen_f64(double lo, double hi, int64_t n) {
+    td_t* v = gen_vec(TD_F64, n);
+    if (!v) return NULL;
+    double* d = (double*)td_data(v);
+    for (int64_t i = 0; i < n; i++) d[i] = lo + (hi - lo) * rng_unit();
+    return v;
+}
+
+/* Consumes `col`; a failed generator or append poisons the whole table. */
+static td_t* add_col(td_t* tbl, const char* name, td_t* col) {
+    if (!tbl || TD_IS_ERR(tbl) || !col) {
+        if (col) td_release(col);
+        if (tbl && !TD_IS_ERR(tbl)) td_release(tbl);
+        return NULL;
+    }
+    tbl = td_table_add_col(tbl, td_sym_intern(name, strlen(name)), col);
+    td_release(col);
+    return tbl;
+}
+
+/* h2o groupby table G1_N_K: id1..id3 SYM (K, K, N/K), id4..id6 I64
+ * (K, K, N/K), v1 I64 [1,5], v2 I64 [1,15], v3 F64 [0,100). */
+static td_t* gen_h2o_groupby(int64_t n, int64_t k) {
+    int64_t nk = n / k > 0 ? n / k : 1;
+    td_t* t = td_table_new(9);
+    t = add_col(t, "id1", gen_sym("id%03lld", k, n));
+    t = add_col(t, "id2", gen_sym("id%03lld", k, n));
+    t = add_col(t, "id3", gen_sym("id%010lld", nk, n));
+    t = add_col(t, "id4", gen_i64(1, k, n));
+    t = add_col(t, "id5", gen_i64(1, k, n));
+    t = add_col(t, "id6", gen_i64(1, nk, n));
+    t = add_col(t, "v1",  gen_i64(1, 5, n));
+    t = add_col(t, "v2",  gen_i64(1, 15, n));
+    t = add_col(t, "v3",  gen_f64(0, 100, n));
+    return t;
+}
+
+/* h2o join: x has N rows with keys drawn from [1, N/10]; y ("medium")
+ * has one row per key. */
+static td_t* gen_h2o_join_x(int64_t n) {
+    int64_t nkey = n / 10 > 0 ? n / 10 : 1;
+    td_t* t = td_table_new(3);
+    t = add_col(t, "id",  gen_i64(1, nkey, n));
+    t = add_col(t, "id4", gen_sym("id%03lld", 100, n));
+    t = add_col(t, "v1",  gen_f64(0, 100, n));
+    return t;
+}
+
+static td_t* gen_h2o_join_y(int64_t n) {
+    int64_t nkey = n / 10 > 0 ? n / 10 : 1;
+    td_t* id = gen_vec(TD_I64, nkey);
+    if (!id) return NULL;
+    int64_t* d = (int64_t*)td_data(id);
+    for (int64_t i = 0; i < nkey; i++) d[i] = i + 1;
+    td_t* t = td_table_new(2);
+    t = add_col(t, "id", id);
+    t = add_col(t, "v2", gen_f64(0, 100, nkey));
+    return t;
+}
+
+/* x stored in key order, as splayed tables written by id or time are:
+ * same key space and about ten rows per key. */
+static td_t* gen_h2o_join_xs(int64_t n) {
+    int64_t nkey = n / 10 > 0 ? n / 10 : 1;
+    td_t* id = gen_vec(TD_I64, n);
+    if (!id) return NULL;
+    int64_t* d = (int64_t*)td_data(id);
+    for (int64_t i = 0; i < n; i++) d[i] = 1 + i * nkey / n;
+    td_t* t = td_table_new(2);
+    t = add_col(t, "id", id);
+    t = add_col(t, "v1", gen_f64(0, 100, n));
+    return t;
+}
+
+/* TPC-H lineitem subset. Ship dates span 1992-01-02 .. 1998-12-01 as in
+ * dbgen; comments come from a small vocabulary so LIKE has something to
+ * find without making the sym table dominate memory. */
+#define TPCH_DATE_LO  8036   /* 1992-01-02 */
+#define TPCH_DATE_HI 10561   /* 1998-12-01 */
+
+static const char* const TPCH_WORDS[] = {
+    "furiously", "special", "requests", "carefully", "final", "deposits",
+    "ironic", "packages", "blithely", "regular", "accounts", "pending",
+    "express", "foxes", "slyly", "bold", "theodolites", "quickly",
+};
+#define TPCH_N_WORDS (sizeof(TPCH_WORDS) / sizeof(TPCH_WORDS[0]))
+#define TPCH_N_COMMENTS 4096
+
+static td_t* gen_tpch_comments(int64_t n) {
+    int64_t ids[TPCH_N_COMMENTS];
+    char buf[160];
+    for (int i = 0; i < TPCH_N_COMMENTS; i++) {
+        size_t len = 0;
+        int words = (int)rng_range(3, 6);
+        for (int w = 0; w < words; w++) {
+            const char* s = TPCH_WORDS[rng_range(0, TPCH_N_WORDS - 1)];
+            len += (size_t)snprintf(buf + len, sizeof(buf) - len, "%s%s",
+                                    w ? " " : "", s);
+        }
+        ids[i] = td_sym_intern(buf, len);
+    }
+    td_t* v = td_sym_vec_new(TD_SYM_W32, n);
+    if (!v || TD_IS_ERR(v)) return NULL;
+    v->len = n;
+    uint32_t* d = (uint32_t*)td_data(v);
+    for (int64_t i = 0; i < n; i++)
+        d[i] = (uint32_t)ids[rng_range(0, TPCH_N_COMMENTS - 1)];
+    return v;
+}
+
+static td_t* gen_tpch_lineitem(int64_t n) {
+    td_t* rf = td_sym_vec_new(TD_SYM_W32, n);
+    td_t* ls = td_sym_vec_new(TD_SYM_W32, n);
+    td_t* sd = gen_vec(TD_DATE, n);
+    if (!rf || TD_IS_ERR(rf) || !ls || TD_IS_ERR(ls) || !sd) return NULL;
+    rf->len = ls->len = n;
+    int64_t rf_ids[3] = { td_sym_intern("A", 1), td_sym_intern("N", 1),
+                          td_sym_intern("R", 1) };
+    int64_t ls_ids[2] = { td_sym_intern("F", 1), td_sym_intern("O", 1) };
+    uint32_t* rfd = (uint32_t*)td_data(rf);
+    uint32_t* lsd = (uint32_t*)td_data(ls);
+    int32_t*  sdd = (int32_t*)td_data(sd);
+    for (int64_t i = 0; i < n; i++) {
+        rfd[i] = (uint32_t)rf_ids[rng_range(0, 2)];
+        lsd[i] = (uint32_t)ls_ids[rng_range(0, 1)];
+        sdd[i] = (int32_t)rng_range(TPCH_DATE_LO, TPCH_DATE_HI);
+    }
+    td_t* t = td_table_new(9);
+    t = add_col(t, "l_orderkey",      gen_i64(1, n / 4 > 0 ? n / 4 : 1, n));
+    t = add_col(t, "l_quantity",      gen_f64(1, 50, n));
+    t = add_col(t, "l_extendedprice", gen_f64(900, 105000, n));
+    t = add_col(t, "l_discount",      gen_f64(0, 0.10, n));
+    t = add_col(t, "l_tax",           gen_f64(0, 0.08, n));
+    t = add_col(t, "l_returnflag",    rf);
+    t = add_col(t, "l_linestatus",    ls);
+    t = add_col(t, "l_shipdate",      sd);
+    t = add_col(t, "l_comment",       gen_tpch_comments(n));
+    return t;
+}
+
+/* Single-type CSV inputs for the csv-<type> cases: four columns of one
+ * type in the widths and shapes real files mix, so rows/s of each case is
+ * the conversion rate of one field parser. */
+enum { CSV_I64, CSV_F64, CSV_DATE, CSV_TS, N_CSV_TYPED };
+static const char* const CSV_TYPED_NAME[N_CSV_TYPED] = {
+    "csv-i64", "csv-f64", "csv-date", "csv-ts",
+};
+
+/* DATE or TIMESTAMP values unit * [lo, hi] */
+static td_t* gen_temporal(int8_t type, int64_t lo, int64_t hi, int64_t unit,
+                          int64_t n) {
+    td_t* v = gen_vec(type, n);
+    if (!v) return NULL;
+    for (int64_t i = 0; i < n; i++) {
+        int64_t x = rng_range(lo, hi) * unit;
+        if (type == TD_DATE) ((int32_t*)td_data(v))[i] = (int32_t)x;
+        else                 ((int64_t*)td_data(v))[i] = x;
+    }
+    return v;
+}
+
+/* Prices: two decimals, formatted short */
+static td_t* gen_cents(int64_t n) {
+    td_t* v = gen_vec(TD_F64, n);
+    if (!v) return NULL;
+    double* d = (double*)td_data(v);
+    for (int64_t i = 0; i < n; i++) d[i] = (double)rng_range(1, 10000000) / 100.0;
+    return v;
+}
+
+static td_t* gen_csv_typed(int kind, int64_t n) {
+    const int64_t ts_lo = 946684800;    /* 2000-01-01, seconds */
+    const int64_t ts_hi = 1893456000;   /* 2030-01-01 */
+    const int64_t us = 1000000;
+    td_t* t = td_table_new(4);
+    switch (kind) {
+    case CSV_I64:
+        t = add_col(t, "a", gen_i64(-999, 999, n));
+        t = add_col(t, "b", gen_i64(0, 999999999, n));
+        t = add_col(t, "c", gen_i64(-999999999999LL, 999999999999LL, n));
+        t = add_col(t, "d", gen_i64(0, 999999999999999999LL, n));
+        break;
+    case CSV_F64:
+        t = add_col(t, "a", gen_cents(n));
+        t = add_col(t, "b", gen_f64(0, 1, n));
+        t = add_col(t, "c", gen_f64(-1e6, 1e6, n));
+        t = add_col(t, "d", gen_f64(0, 1e-3, n));
+        break;
+    case CSV_DATE:
+        t = add_col(t, "a", gen_temporal(TD_DATE, TPCH_DATE_LO, TPCH_DATE_HI, 1, n));
+        t = add_col(t, "b", gen_temporal(TD_DATE, TPCH_DATE_LO, TPCH_DATE_HI, 1, n));
+        t = add_col(t, "c", gen_temporal(TD_DATE, 0, 25000, 1, n));
+        t = add_col(t, "d", gen_temporal(TD_DATE, 0, 25000, 1, n));
+        break;
+    default:
+        /* whole seconds and microsecond precision */
+        t = add_col(t, "a", gen_temporal(TD_TIMESTAMP, ts_lo, ts_hi, us, n));
+        t = add_col(t, "b", gen_temporal(TD_TIMESTAMP, ts_lo, ts_hi, us, n));
+        t = add_col(t, "c", gen_temporal(TD_TIMESTAMP, ts_lo * us, ts_hi * us, 1, n));
+        t = add_col(t, "d", gen_temporal(TD_TIMESTAMP, ts_lo * us, ts_hi * us, 1, n));
+        break;
+    }
+    return t;
+}
+
+/* --------------------------------------------------------------------------
+ * Cases
+ *
+ * Each case builds a fresh graph over its table, so optimizer and graph
+ * construction costs are included — they are part of every real query.
+ * -------------------------------------------------------------------------- */
+
+typedef struct {
+    td_t*       h2o;
+    td_t*       join_x;
+    td_t*       join_y;
+    td_t*       join_xs;
+    td_t*       lineitem;
+    char        csv_path[512];
+    char        out_path[512];
+    char        typed_path[N_CSV_TYPED][512];
+    bool        have_typed[N_CSV_TYPED];
+} bench_data_t;
+
+typedef td_t* (*case_fn)(bench_data_t* d);
+
+typedef struct {
+    const char* name;
+    const char* desc;
+    case_fn     fn;
+    int         table;           /* 0 h2o, 1 join_x, 2 lineitem,
+                                  * 3 + CSV_* typed CSV: for rows/s */
+} bench_case_t;
+
+static td_t* run_graph(td_graph_t* g, td_op_t* root) {
+    td_t* r = td_execute(g, td_optimize(g, root));
+    td_graph_free(g);
+    return r;
+}
+
+/* Group-by over a filter: the predicate is evaluated first and handed to
+ * the group as g->selection, as the addon does for filter().groupBy(). */
+static td_t* run_selected(td_graph_t* g, td_op_t* pred, td_op_t* root) {
+    td_t* bools = td_execute(g, pred);
+    td_t* mask = td_sel_from_pred(bools);
+    if (bools && !TD_IS_ERR(bools)) td_release(bools);
+    if (!mask || TD_IS_ERR(mask)) {
+        td_graph_free(g);
+        return mask;
+    }
+    g->selection = mask;
+    return run_graph(g, root);
+}
+
+static td_t* case_groupby_low(bench_data_t* d) {
+    td_graph_t* g = td_graph_new(d->h2o);
+    td_op_t* k = td_scan(g, "id1");
+    td_op_t* v = td_scan(g, "v1");
+    uint16_t ops[] = { OP_SUM };
+    return run_graph(g, td_group(g, &k, 1, ops, &v, 1));
+}
+
+static td_t* case_groupby_high(bench_data_t* d) {
+    td_graph_t* g = td_graph_new(d->h2o);
+    td_op_t* k = td_scan(g, "id3");
+    td_op_t* ins[] = { td_scan(g, "v1"), td_scan(g, "v3") };
+    uint16_t ops[] = { OP_SUM, OP_AVG };
+    return run_graph(g, td_group(g, &k, 1, ops, ins, 2));
+}
+
+static td_t* case_groupby_multi(bench_data_t* d) {
+    td_graph_t* g = td_graph_new(d->h2o);
+    td_op_t* ks[] = { td_scan(g, "id4"), td_scan(g, "id5") };
+    td_op_t* ins[] = { td_scan(g, "v1"), td_scan(g, "v2"), td_scan(g, "v3") };
+    uint16_t ops[] = { OP_SUM, OP_SUM, OP_SUM };
+    return run_graph(g, td_group(g, ks, 2, ops, ins, 3));
+}
+
+static td_t* case_join_inner(bench_data_t* d) {
+    td_graph_t* g = td_graph_new(d->join_x);
+    td_op_t* lk = td_scan(g, "id");
+    td_op_t* rk = td_scan(g, "id");
+    return run_graph(g, td_join(g, td_const_table(g, d->join_x), &lk,
+                                td_const_table(g, d->join_y), &rk, 1, 0));
+}
+
+static td_t* case_join_left(bench_data_t* d) {
+    td_graph_t* g = td_graph_new(d->join_x);
+    td_op_t* lk = td_scan(g, "id");
+    td_op_t* rk = td_scan(g, "id");
+    return run_graph(g, td_join(g, td_const_table(g, d->join_x), &lk,
+                                td_const_table(g, d->join_y), &rk, 1, 1));
+}
+
+/* Both sides sorted on id: merge join instead of a hash table */
+static td_t* case_join_sorted(bench_data_t* d) {
+    td_graph_t* g = td_graph_new(d->join_xs);
+    td_op_t* lk = td_scan(g, "id");
+    td_op_t* rk = td_scan(g, "id");
+    return run_graph(g, td_join(g, td_const_table(g, d->join_xs), &lk,
+                                td_const_table(g, d->join_y), &rk, 1, 0));
+}
+
+/* N/10 groups arriving in key order: streaming group-by */
+static td_t* case_groupby_sorted(bench_data_t* d) {
+    td_graph_t* g = td_graph_new(d->join_xs);
+    td_op_t* k = td_scan(g, "id");
+    td_op_t* v = td_scan(g, "v1");
+    uint16_t ops[] = { OP_SUM };
+    return run_graph(g, td_group(g, &k, 1, ops, &v, 1));
+}
+
+static td_t* case_sort_multi(bench_data_t* d) {
+    td_graph_t* g = td_graph_new(d->h2o);
+    td_op_t* ks[] = { td_scan(g, "id1"), td_scan(g, "v3") };
+    uint8_t descs[] = { 0, 1 };
+    return run_graph(g, td_sort_op(g, td_const_table(g, d->h2o),
+                                   ks, descs, NULL, 2));
+}
+
+static td_t* case_topn(bench_data_t* d) {
+    td_graph_t* g = td_graph_new(d->h2o);
+    td_op_t* k = td_scan(g, "v3");
+    uint8_t desc = 1;
+    td_op_t* s = td_sort_op(g, td_const_table(g, d->h2o), &k, &desc, NULL, 1);
+    return run_graph(g, td_head(g, s, 100));
+}
+
+/* COUNT over the matching rows keeps the result tiny, so the case measures
+ * the LIKE scan rather than materialization. */
+static td_t* case_like(bench_data_t* d) {
+    td_graph_t* g = td_graph_new(d->lineitem);
+    td_op_t* pred = td_like(g, td_scan(g, "l_comment"),
+                            td_const_str(g, "%special%requests%"));
+    return run_graph(g, td_count(g, td_filter(g, td_scan(g, "l_orderkey"), pred)));
+}
+
+static td_t* case_window(bench_data_t* d) {
+    td_graph_t* g = td_graph_new(d->h2o);
+    td_op_t* part = td_scan(g, "id1");
+    td_op_t* ord = td_scan(g, "v3");
+    uint8_t desc = 0;
+    uint8_t kinds[] = { TD_WIN_ROW_NUMBER, TD_WIN_SUM };
+    td_op_t* ins[] = { ord, td_scan(g, "v1") };
+    int64_t params[] = { 0, 0 };
+    return run_graph(g, td_window_op(g, td_const_table(g, d->h2o),
+                                     &part, 1, &ord, &desc, 1,
+                                     kinds, ins, params, 2,
+                                     TD_FRAME_ROWS,
+                                     TD_BOUND_UNBOUNDED_PRECEDING,
+                                     TD_BOUND_CURRENT_ROW, 0, 0));
+}
+
+/* TPC-H Q1: pricing summary report (without the derived charge columns) */
+static td_t* case_tpch_q1(bench_data_t* d) {
+    td_graph_t* g = td_graph_new(d->lineitem);
+    td_op_t* pred = td_le(g, td_scan(g, "l_shipdate"),
+                          td_const_i64(g, TPCH_DATE_HI - 90));
+    td_op_t* ks[] = { td_scan(g, "l_returnflag"), td_scan(g, "l_linestatus") };
+    td_op_t* ins[] = {
+        td_scan(g, "l_quantity"), td_scan(g, "l_extendedprice"),
+        td_scan(g, "l_discount"), td_scan(g, "l_quantity"),
+    };
+    uint16_t ops[] = { OP_SUM, OP_SUM, OP_AVG, OP_COUNT };
+    return run_selected(g, pred, td_group(g, ks, 2, ops, ins, 4));
+}
+
+/* TPC-H Q6: forecasting revenue change */
+static td_t* case_tpch_q6(bench_data_t* d) {
+    td_graph_t* g = td_graph_new(d->lineitem);
+    td_op_t* sd = td_scan(g, "l_shipdate");
+    td_op_t* disc = td_scan(g, "l_discount");
+    td_op_t* pred = td_and(g,
+        td_and(g, td_ge(g, sd, td_const_i64(g, 8766)),      /* 1994-01-01 */
+                  td_lt(g, sd, td_const_i64(g, 9131))),     /* 1995-01-01 */
+        td_and(g,
+            td_and(g, td_ge(g, disc, td_const_f64(g, 0.05)),
+                      td_le(g, disc, td_const_f64(g, 0.07))),
+            td_lt(g, td_scan(g, "l_quantity"), td_const_f64(g, 24))));
+    td_op_t* rev = td_mul(g, td_scan(g, "l_extendedprice"), disc);
+    return run_graph(g, td_sum(g, td_filter(g, rev, pred)));
+}
+
+static td_t* case_csv_read(bench_data_t* d) {
+    return td_read_csv(d->csv_path);
+}
+
+static td_t* case_csv_i64(bench_data_t* d)  { return td_read_csv(d->typed_path[CSV_I64]); }
+static td_t* case_csv_f64(bench_data_t* d)  { return td_read_csv(d->typed_path[CSV_F64]); }
+static td_t* case_csv_date(bench_data_t* d) { return td_read_csv(d->typed_path[CSV_DATE]); }
+static td_t* case_csv_ts(bench_data_t* d)   { return td_read_csv(d->typed_path[CSV_TS]); }
+
+static td_t* case_csv_write(bench_data_t* d) {
+    td_err_t err = td_write_csv(d->lineitem, d->out_path);
+    if (err != TD_OK) return TD_ERR_PTR(err);
+    td_retain(d->lineitem);
+    return d->lineitem;
+}
+
+static const bench_case_t CASES[] = {
+    { "groupby-low",   "sum v1 by id1 (K groups)",            case_groupby_low,   0 },
+    { "groupby-high",  "sum v1, avg v3 by id3 (N/K groups)",  case_groupby_high,  0 },
+    { "groupby-multi", "sum v1..v3 by id4, id5",              case_groupby_multi, 0 },
+    { "join-inner",    "x inner join y on id (N x N/10)",     case_join_inner,    1 },
+    { "join-left",     "x left join y on id (N x N/10)",      case_join_left,     1 },
+    { "join-sorted",   "sorted x inner join y on id",         case_join_sorted,   1 },
+    { "groupby-sorted", "sum v1 by sorted id (N/10 groups)",  case_groupby_sorted, 1 },
+    { "sort-multi",    "sort by id1 asc, v3 desc",            case_sort_multi,    0 },
+    { "topn",          "top 100 by v3 desc",                  case_topn,          0 },
+    { "like",          "l_comment like %special%requests%",   case_like,          2 },
+    { "window",        "row_number, running sum by id1",      case_window,        0 },
+    { "tpch-q1",       "TPC-H Q1 aggregate",                  case_tpch_q1,       2 },
+    { "tpch-q6",       "TPC-H Q6 filtered revenue",           case_tpch_q6,       2 },
+    { "csv-read",      "parse lineitem CSV",                  case_csv_read,      2 },
+    { "csv-i64",       "parse 4 I64 columns, 3 to 18 digits", case_csv_i64,       3 + CSV_I64 },
+    { "csv-f64",       "parse 4 F64 columns, short and full", case_csv_f64,       3 + CSV_F64 },
+    { "csv-date",      "parse 4 DATE columns",                case_csv_date,      3 + CSV_DATE },
+    { "csv-ts",        "parse 4 TIMESTAMP columns",           case_csv_ts,        3 + CSV_TS },
+    { "csv-write",     "format lineitem as CSV",              case_csv_write,     2 },
+};
+#define N_CASES (sizeof(CASES) / sizeof(CASES[0]))
+
+/* --------------------------------------------------------------------------
+ * Driver
+ * -------------------------------------------------------------------------- */
+
+/* The calling thread always takes part in dispatch, so t threads means
+ * t-1 pool workers. */
+static bool set_threads(uint32_t t, bool pin) {
+    td_pool_destroy();
+    td_pool_opts_t po = { t, NULL, 0, pin ? TD_POOL_PIN | TD_POOL_NUMA : 0 };
+    return td_pool_init_ex(&po) == TD_OK;
+}
+
+int main(int argc, char** argv) {
+    bench_opts_t o = {
+        .n_rows = 10000000, .k = 100, .reps = 3,
+        .n_threads = 1, .only = NULL, .tmpdir = NULL, .csv_out = false,
+        .pin = false,
+    };
+    o.threads[0] = td_thread_count();
+
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        const char* v = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (strcmp(a, "--csv") == 0) { o.csv_out = true; continue; }
+        if (strcmp(a, "--pin") == 0) { o.pin = true; continue; }
+        if (!v) { usage(argv[0]); return 2; }
+        if      (strcmp(a, "-n") == 0) o.n_rows = (int64_t)strtod(v, NULL);
+        else if (strcmp(a, "-k") == 0) o.k = strtoll(v, NULL, 10);
+        else if (strcmp(a, "-r") == 0) o.reps = atoi(v);
+        else if (strcmp(a, "-c") == 0) o.only = v;
+        else if (strcmp(a, "-d") == 0) o.tmpdir = v;
+        else if (strcmp(a, "-t") == 0) {
+            if (parse_threads(&o, v) != 0) { usage(argv[0]); return 2; }
+        }
+        else { usage(argv[0]); return 2; }
+        i++;
+    }
+    if (o.n_rows < 1 || o.k < 1 || o.reps < 1) { usage(argv[0]); return 2; }
+
+    td_heap_init();
+    td_sym_init();
+
+    bench_data_t d;
+    memset(&d, 0, sizeof(d));
+    int64_t t0 = td_time_ns();
+    d.h2o      = gen_h2o_groupby(o.n_rows, o.k);
+    d.join_x   = gen_h2o_join_x(o.n_rows);
+    d.join_y   = gen_h2o_join_y(o.n_rows);
+    d.join_xs  = gen_h2o_join_xs(o.n_rows);
+    d.lineitem = gen_tpch_lineitem(o.n_rows);
+    if (!d.h2o || TD_IS_ERR(d.h2o) || !d.join_x || TD_IS_ERR(d.join_x) ||
+        !d.join_y || TD_IS_ERR(d.join_y) ||
+        !d.join_xs || TD_IS_ERR(d.join_xs) ||
+        !d.lineitem || TD_IS_ERR(d.lineitem)) {
+        fprintf(stderr, "teide_bench: data generation failed\n");
+        return 1;
+    }
+
+    const char* tmp = o.tmpdir ? o.tmpdir : getenv("TMPDIR");
+    if (!tmp || !*tmp) tmp = "/tmp";
+    snprintf(d.csv_path, sizeof(d.csv_path), "%s/teide_bench_lineitem_%ld.csv",
+             tmp, (long)o.n_rows);
+    snprintf(d.out_path, sizeof(d.out_path), "%s/teide_bench_out_%ld.csv",
+             tmp, (long)o.n_rows);
+    bool have_csv = !o.only || strstr("csv-read", o.only);
+    if (have_csv && td_write_csv(d.lineitem, d.csv_path) != TD_OK) {
+        fprintf(stderr, "teide_bench: cannot write %s\n", d.csv_path);
+        have_csv = false;
+    }
+    for (int k = 0; k < N_CSV_TYPED; k++) {
+        if (o.only && !strstr(CSV_TYPED_NAME[k], o.only)) continue;
+        snprintf(d.typed_path[k], sizeof(d.typed_path[k]), "%s/teide_bench_%s_%ld.csv",
+                 tmp, CSV_TYPED_NAME[k] + 4, (long)o.n_rows);
+        td_t* t = gen_csv_typed(k, o.n_rows);
+        d.have_typed[k] = t && !TD_IS_ERR(t) &&
+                          td_write_csv(t, d.typed_path[k]) == TD_OK;
+        if (t && !TD_IS_ERR(t)) td_release(t);
+        if (!d.have_typed[k])
+            fprintf(stderr, "teide_bench: cannot write %s\n", d.typed_path[k]);
+    }
+    int64_t gen_ns = td_time_ns() - t0;
+
+    int64_t rows_of[3 + N_CSV_TYPED] = {
+        td_table_nrows(d.h2o), td_table_nrows(d.join_x), td_table_nrows(d.lineitem),
+        o.n_rows, o.n_rows, o.n_rows, o.n_rows,
+    };
+
+    if (o.csv_out) {
+        printf("case,threads,rows,out_rows,best_ms,median_ms,rows_per_s,peak_rss_bytes,speedup\n");
+    } else {
+        printf("teide_bench: n=%ld k=%ld reps=%d cpus=%u (generated in %.0f ms)\n\n",
+               (long)o.n_rows, (long)o.k, o.reps, td_thread_count(),
+               (double)gen_ns / 1e6);
+        printf("%-14s %4s %10s %10s %10s %10s %10s %8s\n", "case", "thr",
+               "out rows", "best ms", "median ms", "Mrows/s", "peak RSS", "speedup");
+    }
+
+    int64_t* samples = (int64_t*)malloc((size_t)o.reps * sizeof(int64_t));
+    int failed = 0;
+
+    for (size_t c = 0; c < N_CASES; c++) {
+        const bench_case_t* bc = &CASES[c];
+        if (o.only && !strstr(bc->name, o.only)) continue;
+        if (bc->fn == case_csv_read && !have_csv) continue;
+        if (bc->table >= 3 && !d.have_typed[bc->table - 3]) continue;
+
+        double base_ms = 0;
+        for (int ti = 0; ti < o.n_threads; ti++) {
+            uint32_t t = o.threads[ti];
+            if (!set_threads(t, o.pin)) {
+                if (!o.csv_out)
+                    printf("%-14s %4u  (skipped: cannot start the pool)\n",
+                           bc->name, t);
+                continue;
+            }
+
+            /* Warm-up run: first-touch page faults and sym lookups are
+             * not what we want to compare across versions. */
+            td_t* r = bc->fn(&d);
+            if (!r || TD_IS_ERR(r)) {
+                fprintf(stderr, "teide_bench: %s failed: %s\n", bc->name,
+                        r ? td_err_str(TD_ERR_CODE(r)) : "null result");
+                failed = 1;
+                break;
+            }
+            int64_t out_rows = result_rows(r);
+            td_release(r);
+            td_heap_gc();
+
+            rss_reset_peak();
+            for (int rep = 0; rep < o.reps; rep++) {
+                int64_t s = td_time_ns();
+                r = bc->fn(&d);
+                samples[rep] = td_time_ns() - s;
+                if (r && !TD_IS_ERR(r)) td_release(r);
+                td_heap_gc();
+            }
+            int64_t peak = rss_peak_bytes();
+
+            qsort(samples, (size_t)o.reps, sizeof(int64_t), cmp_i64);
+            double best_ms = (double)samples[0] / 1e6;
+            double med_ms  = (double)samples[o.reps / 2] / 1e6;
+            int64_t rows   = rows_of[bc->table];
+            double rps     = best_ms > 0 ? (double)rows / (best_ms / 1e3) : 0;
+            if (base_ms == 0) base_ms = best_ms;
+            double speedup = best_ms > 0 ? base_ms / best_ms : 0;
+
+            if (o.csv_out)
+                printf("%s,%u,%ld,%ld,%.3f,%.3f,%.0f,%ld,%.2f\n", bc->name, t,
+                       (long)rows, (long)out_rows, best_ms, med_ms, rps,
+                       (long)peak, speedup);
+            else
+                printf("%-14s %4u %10ld %10.2f %10.2f %10.2f %8.0fMB %7.2fx\n",
+                       bc->name, t, (long)out_rows, best_ms, med_ms, rps / 1e6,
+                       (double)peak / (1 << 20), speedup);
+            fflush(stdout);
+        }
+    }
+
+    free(samples);
+    if (have_csv) remove(d.csv_path);
+    for (int k = 0; k < N_CSV_TYPED; k++)
+        if (d.have_typed[k]) remove(d.typed_path[k]);
+    remove(d.out_path);
+    td_release(d.h2o);
+    td_release(d.join_x);
+    td_release(d.join_y);
+    td_release(d.join_xs);
+    td_release(d.lineitem);
+    td_pool_destroy();
+    td_sym_destroy();
+    td_heap_destroy();
+    return failed;
+}
@@ -0,0 +1,62 @@
+import path from 'path';
+
+const addon = require(path.join(__dirname, '..', 'build', 'Release', 'teidedb_addon.node'));
+
+export interface CancelOptions {
+    /** Abort the operation when this signal fires. Queued work is dropped
+     *  before it starts; running work stops at the next morsel boundary. */
+    signal?: AbortSignal;
+    /** Give up after this many milliseconds (measured from submission). */
+    timeoutMs?: number;
+}
+
+export interface SyncCancelOptions {
+    /** Give up after this many milliseconds (measured from submission). */
+    timeoutMs?: number;
+}
+
+function timeoutError(): Error {
+    return new DOMException('The operation timed out', 'TimeoutError');
+}
+
+function isCancelError(e: unknown): boolean {
+    return e instanceof Error && e.message.endsWith('query cancelled');
+}
+
+/** @internal Run a blocking native call with an optional deadline. */
+export function runSync<T>(opts: SyncCancelOptions | undefined,
+                           call: (nativeOpts: object | undefined) => T): T {
+    if (opts?.timeoutMs === undefined) return call(undefined);
+    try {
+        return call({ timeoutMs: opts.timeoutMs });
+    } catch (e) {
+        throw isCancelError(e) ? timeoutError() : e;
+    }
+}
+
+/** @internal Run an async native call bound to a fresh cancel token. */
+export async function runCancellable<T>(opts: CancelOptions | undefined,
+                                        call: (nativeOpts: object | undefined) => Promise<T>): Promise<T> {
+    const signal = opts?.signal;
+    const timeoutMs = opts?.timeoutMs;
+    if (!signal && timeoutMs === undefined) return call(undefined);
+
+    signal?.throwIfAborted();
+    const token = new addon.NativeCancelToken();
+    const onAbort = () => token.cancel();
+    const timer = timeoutMs !== undefined
+        ? setTimeout(onAbort, timeoutMs)
+        : undefined;
+    signal?.addEventListener('abort', onAbort, { once: true });
+    try {
+        // timeoutMs also goes native so items still queued past their
+        // deadline are skipped even if this event loop is busy.
+        return await call({ token, timeoutMs });
+    } catch (e) {
+        if (!isCancelError(e)) throw e;
+        throw signal?.aborted ? signal.reason : timeoutError();
+    } finally {
+        clearTimeout(timer);
+        signal?.removeEventListener('abort', onAbort);
+    }
+}
@@ -1,27 +1,112 @@
 import { Table } from './table';
+import type { Query, CollectOptions, CollectSyncOptions } from './query';
+import { CancelOptions, SyncCancelOptions, runCancellable, runSync } from './cancel';
+import { ContextStats } from './stats';
 import path from 'path';
 
 const addon = require(path.join(__dirname, '..', 'build', 'Release', 'teidedb_addon.node'));
 
+/** Worker pool and heap settings. The pool is shared by every context in the
+ *  process: the first context that passes options creates it (later ones
+ *  must agree on `threads`), and without options it starts on first use
+ *  with one thread per available CPU. */
+export interface ContextOptions {
+    /** Threads running query morsels, including the query thread itself. */
+    threads?: number;
+    /** CPU ids to run on; implies `pin`. Threads are assigned round-robin.
+     *  Each id must be a CPU this process may run on, and the context throws
+     *  if a thread cannot be pinned. */
+    cpus?: number[];
+    /** Pin each pool thread to one CPU (default: true when `cpus` is set). */
+    pin?: boolean;
+    /** With pinning, bind each worker's heap to its NUMA node and give each
+     *  node its own range of morsels (default: true). */
+    numa?: boolean;
+    /** Back heap pools with 2 MB huge pages: transparent ones with `true`,
+     *  reserved hugetlbfs pages with `'explicit'` (falling back to
+     *  transparent ones when none are free). Cuts TLB misses and page
+     *  faults on large scans and group-bys. Process-wide. */
+    hugePages?: boolean | 'explicit';
+    /** Fault in large result buffers and mapped column files in one call
+     *  when they are created, instead of page by page. Process-wide. */
+    prefault?: boolean;
+    /** Bytes of emptied large-allocation pools kept mapped between
+     *  queries, so repeated large results reuse warm memory instead of
+     *  mapping and faulting it again. Process-wide (default 0). */
+    warmReserveBytes?: number;
+    /** Heap bytes this context may spend keeping query results, so that
+     *  repeating a query over an unchanged table returns the earlier result.
+     *  Least recently used results are dropped first; appending to a table
+     *  drops the results computed from it. Off when 0 or omitted.
+     *  A table whose `.data` was read is no longer cached from, since the
+     *  view lets its rows change, and the columns of a result that went
+     *  through the cache are copied out by `.data` rather than viewed. */
+    resultCacheBytes?: number;
+}
+
+/** Withdraw a handle returned by `Table.publish()`; returns false if it was
+ *  not published (or already withdrawn). Tables already opened from it
+ *  stay usable: the shared rows are freed with the last of them. */
+export function unpublish(handle: string): boolean {
+    return addon.unpublish(handle);
+}
+
 export class Context {
     private _native: any;
     private _destroyed = false;
 
-    constructor() {
-        this._native = new addon.NativeContext();
+    constructor(opts?: ContextOptions) {
+        this._native = new addon.NativeContext(opts);
     }
 
-    readCsvSync(filePath: string): Table {
+    readCsvSync(filePath: string, opts?: SyncCancelOptions): Table {
         this._checkAlive();
-        return new Table(this._native.readCsvSync(filePath), this._native);
+        const nativeTable = runSync(opts, (o) => this._native.readCsvSync(filePath, o));
+        return new Table(nativeTable, this._native);
     }
 
-    async readCsv(filePath: string): Promise<Table> {
+    async readCsv(filePath: string, opts?: CancelOptions): Promise<Table> {
         this._checkAlive();
-        const nativeTable = await this._native.readCsv(filePath);
+        const nativeTable = await runCancellable(opts, (o) => this._native.readCsv(filePath, o));
         return new Table(nativeTable, this._native);
     }
 
+    /** Open a table published with `Table.publish()`, possibly by another
+     *  context or worker_thread. Nothing is copied; the table is
+     *  read-only, so `append()` throws, and stays valid after the
+     *  publishing context is destroyed. */
+    openShared(handle: string): Table {
+        this._checkAlive();
+        return new Table(this._native.openShared(handle), this._native);
+    }
+
+    /** Run several queries as one batch. Queries over the same table share
+     *  one pass: common scans, filters and computed columns are evaluated
+     *  once, and queries that open with the same filters and group keys are
+     *  answered by a single group-by holding all of their aggregates.
+     *  Results come back in query order; if any query fails, the call
+     *  rejects with its error. */
+    async collectMany(queries: Query[], opts?: Omit<CollectOptions, 'profile'>): Promise<Table[]> {
+        const [tables, ops] = this._batch(queries);
+        const results: any[] = await runCancellable(opts, (o) =>
+            addon.collectMany(tables, ops, { ...o, cache: opts?.cache }));
+        return results.map((r) => new Table(r, this._native));
+    }
+
+    collectManySync(queries: Query[], opts?: Omit<CollectSyncOptions, 'profile'>): Table[] {
+        const [tables, ops] = this._batch(queries);
+        const results: any[] = runSync(opts, (o) =>
+            addon.collectManySync(tables, ops, { ...o, cache: opts?.cache }));
+        return results.map((r) => new Table(r, this._native));
+    }
+
+    /** Memory, worker pool, symbol table and work queue metrics. Cheap
+     *  enough to poll; never blocks behind a running query. */
+    stats(): ContextStats {
+        this._checkAlive();
+        return this._native.stats();
+    }
+
     destroy(): void {
         if (!this._destroyed) {
             this._native.destroy();
@@ -33,6 +118,15 @@ export class Context {
         this.destroy();
     }
 
+    private _batch(queries: Query[]): [any[], object[][]] {
+        this._checkAlive();
+        const plans = queries.map((q) => q._plan());
+        if (plans.some((p) => p.ctx !== this._native)) {
+            throw new Error('collectMany: every query must come from this context');
+        }
+        return [plans.map((p) => p.table), plans.map((p) => p.ops)];
+    }
+
     private _checkAlive(): void {
         if (this._destroyed) throw new Error('Context has been destroyed');
     }
@@ -0,0 +1,74 @@
+import { dtypeName } from './series';
+
+/** One node of an optimized plan. Profile fields are present only on nodes
+ *  that were executed under `collect({ profile: true })`. */
+export interface PlanNode {
+    id: number;
+    op: string;
+    detail?: string;
+    outType: number;
+    estRows: number;
+    fused: boolean;
+    /** Evaluated once and reused by every consumer (common subexpression). */
+    shared: boolean;
+    children: PlanNode[];
+
+    calls?: number;
+    timeMs?: number;         // inclusive of children
+    selfTimeMs?: number;
+    rowsIn?: number;
+    rowsOut?: number;
+    memNetBytes?: number;    // heap still held on exit (query thread)
+    memPeakBytes?: number;   // heap high-water above entry (query thread)
+    morsels?: number;        // pool tasks dispatched by this node itself
+    dispatches?: number;
+    paths?: string[];        // 'parallel' | 'radix' | 'direct-array' | 'top-n' | 'lazy-selection' | 'merge'
+                             // | 'late-materialization' | 'partition-wise'
+}
+
+export interface PlanProfile {
+    root?: PlanNode;
+    /** Filter evaluated ahead of a group-by into a row selection. */
+    selection?: PlanNode;
+    totalMs?: number;
+}
+
+function fmtBytes(n: number): string {
+    const a = Math.abs(n);
+    if (a >= 1 << 30) return `${(n / (1 << 30)).toFixed(1)}GiB`;
+    if (a >= 1 << 20) return `${(n / (1 << 20)).toFixed(1)}MiB`;
+    if (a >= 1 << 10) return `${(n / (1 << 10)).toFixed(1)}KiB`;
+    return `${n}B`;
+}
+
+function fmtNode(n: PlanNode): string {
+    let s = n.op;
+    if (n.detail) s += ` ${n.detail}`;
+    s += ` -> ${dtypeName(n.outType)}`;
+    if (n.fused) s += ' (fused)';
+    if (n.shared) s += ' (shared)';
+    if (n.calls === undefined) return s;
+    s += `  [${n.timeMs!.toFixed(3)}ms self=${n.selfTimeMs!.toFixed(3)}ms`;
+    s += ` rows=${n.rowsIn}->${n.rowsOut}`;
+    s += ` mem=${fmtBytes(n.memNetBytes!)} peak=${fmtBytes(n.memPeakBytes!)}`;
+    if (n.morsels) s += ` morsels=${n.morsels}`;
+    if (n.paths && n.paths.length) s += ` ${n.paths.join(',')}`;
+    return s + ']';
+}
+
+function fmtTree(n: PlanNode, indent: string, out: string[]): void {
+    out.push(indent + fmtNode(n));
+    for (const c of n.children) fmtTree(c, indent + '  ', out);
+}
+
+/** Render a plan as an indented tree, one node per line. */
+export function formatPlan(plan: PlanProfile): string {
+    const out: string[] = [];
+    if (plan.totalMs !== undefined) out.push(`total ${plan.totalMs.toFixed(3)}ms`);
+    if (plan.selection) {
+        out.push('selection:');
+        fmtTree(plan.selection, '  ', out);
+    }
+    if (plan.root) fmtTree(plan.root, '', out);
+    return out.join('\n');
+}
@@ -1,4 +1,6 @@
-export type ExprKind = 'col' | 'lit' | 'binop' | 'unop' | 'agg' | 'alias';
+import { dtypeCode } from './series';
+
+export type ExprKind = 'col' | 'lit' | 'binop' | 'unop' | 'agg' | 'alias' | 'in' | 'call';
 
 // Agg opcodes (must match C defines in td.h)
 export const OP_SUM = 50;
@@ -9,6 +11,31 @@ export const OP_COUNT = 54;
 export const OP_AVG = 55;
 export const OP_FIRST = 56;
 export const OP_LAST = 57;
+export const OP_QUANTILE = 77;
+export const OP_QUANTILE_APPROX = 78;
+
+export interface QuantileOptions {
+    // Estimate from a mergeable t-digest sketch instead of selecting exactly
+    approximate?: boolean;
+}
+
+// Date/time fields for extract() and dateTrunc() (TD_EXTRACT_* in td.h)
+const DATE_FIELDS: Record<string, number> = {
+    year: 0, month: 1, day: 2, hour: 3, minute: 4, second: 5, dow: 6, doy: 7, epoch: 8,
+};
+
+export type DateField = 'year' | 'month' | 'day' | 'hour' | 'minute' | 'second' | 'dow' | 'doy' | 'epoch';
+
+// timeBucket() width units (TD_BUCKET_* in td.h): plain numbers are in the
+// column's own units; suffixed strings count microseconds or months
+const BUCKET_RAW = 0;
+const BUCKET_USEC = 1;
+const BUCKET_MONTH = 2;
+const BUCKET_UNITS: Record<string, [number, number]> = {
+    us: [BUCKET_USEC, 1], ms: [BUCKET_USEC, 1e3], s: [BUCKET_USEC, 1e6], m: [BUCKET_USEC, 6e7],
+    h: [BUCKET_USEC, 3.6e9], d: [BUCKET_USEC, 8.64e10], w: [BUCKET_USEC, 6.048e11],
+    mo: [BUCKET_MONTH, 1], q: [BUCKET_MONTH, 3], y: [BUCKET_MONTH, 12],
+};
 
 export class Expr {
     constructor(
@@ -35,6 +62,23 @@ export class Expr {
     and(other: Expr): Expr { return binop('and', this, other); }
     or(other: Expr): Expr { return binop('or', this, other); }
 
+    // Pairwise extremes
+    least(other: Expr | number): Expr { return binop('min2', this, wrap(other)); }
+    greatest(other: Expr | number): Expr { return binop('max2', this, wrap(other)); }
+
+    // Pattern match: % matches any run of characters, _ any one character
+    like(pattern: string): Expr { return binop('like', this, lit(pattern)); }
+    ilike(pattern: string): Expr { return binop('ilike', this, lit(pattern)); }
+
+    // Membership: strings for symbol columns, numbers/booleans otherwise
+    isIn(values: ReadonlyArray<number | string | boolean>): Expr {
+        const strings = values.filter((v) => typeof v === 'string').length;
+        if (strings !== 0 && strings !== values.length) {
+            throw new TypeError('isIn: values must be all strings or all numbers');
+        }
+        return new Expr('in', { arg: this, values: [...values] });
+    }
+
     // Unary
     not(): Expr { return new Expr('unop', { op: 'not', arg: this }); }
     neg(): Expr { return new Expr('unop', { op: 'neg', arg: this }); }
@@ -46,6 +90,29 @@ export class Expr {
     floor(): Expr { return new Expr('unop', { op: 'floor', arg: this }); }
     isNull(): Expr { return new Expr('unop', { op: 'isnull', arg: this }); }
 
+    // Strings
+    upper(): Expr { return new Expr('unop', { op: 'upper', arg: this }); }
+    lower(): Expr { return new Expr('unop', { op: 'lower', arg: this }); }
+    strlen(): Expr { return new Expr('unop', { op: 'strlen', arg: this }); }
+    trim(): Expr { return new Expr('unop', { op: 'trim', arg: this }); }
+    /** `len` characters from 1-based position `start`. */
+    substr(start: Expr | number, len: Expr | number): Expr {
+        return call('substr', [this, wrap(start), wrap(len)]);
+    }
+    replace(from: string, to: string): Expr {
+        return call('replace', [this, lit(from), lit(to)]);
+    }
+    concat(...others: Array<Expr | string>): Expr { return concat(this, ...others); }
+
+    // Conversion
+    cast(dtype: string): Expr { return call('cast', [this], dtypeCode(dtype)); }
+
+    // Dates and times
+    extract(field: DateField): Expr { return call('extract', [this], dateField(field)); }
+    dateTrunc(field: DateField): Expr { return call('date_trunc', [this], dateField(field)); }
+    /** Floor to multiples of `width` counted from `origin` (see timeBucket()). */
+    timeBucket(width: number | string, origin = 0): Expr { return timeBucket(this, width, origin); }
+
     // Aggregations
     sum(): Expr { return new Expr('agg', { op: OP_SUM, arg: this }); }
     mean(): Expr { return new Expr('agg', { op: OP_AVG, arg: this }); }
@@ -54,6 +121,12 @@ export class Expr {
     count(): Expr { return new Expr('agg', { op: OP_COUNT, arg: this }); }
     first(): Expr { return new Expr('agg', { op: OP_FIRST, arg: this }); }
     last(): Expr { return new Expr('agg', { op: OP_LAST, arg: this }); }
+    quantile(q: number, opts: QuantileOptions = {}): Expr {
+        if (!(q >= 0 && q <= 1)) throw new TypeError(`quantile: ${q} is not in [0, 1]`);
+        return new Expr('agg', { op: opts.approximate ? OP_QUANTILE_APPROX : OP_QUANTILE, arg: this, q });
+    }
+    median(opts: QuantileOptions = {}): Expr { return this.quantile(0.5, opts); }
+    percentile(pct: number, opts: QuantileOptions = {}): Expr { return this.quantile(pct / 100, opts); }
 
     // Rename
     alias(name: string): Expr { return new Expr('alias', { name, arg: this }); }
@@ -67,6 +140,45 @@ export function lit(value: number | string | boolean): Expr {
     return new Expr('lit', { value });
 }
 
+/** Row-wise `cond ? then : otherwise`. */
+export function ifElse(
+    cond: Expr,
+    then: Expr | number | string | boolean,
+    otherwise: Expr | number | string | boolean,
+): Expr {
+    return call('if', [cond, wrap(then), wrap(otherwise)]);
+}
+
+export function concat(...args: Array<Expr | string>): Expr {
+    if (args.length < 2) throw new TypeError('concat: needs at least two arguments');
+    return call('concat', args.map(wrap));
+}
+
+/**
+ * Floor `expr` to the start of its bucket: `origin + floor((x - origin) / width) * width`.
+ * A number `width` is in the column's own units (kdb+ `xbar`). A string
+ * such as `'5m'`, `'1h'`, `'1d'` or `'1w'` is a fixed duration (`us`, `ms`,
+ * `s`, `m`, `h`, `d`, `w`) of a timestamp or date column; `'1mo'`, `'1q'` and
+ * `'1y'` are calendar months, quarters and years. `origin` is in the column's
+ * units. A string `expr` names a column. Grouping by a bucket of a column
+ * is done without building the bucketed column.
+ */
+export function timeBucket(expr: Expr | string, width: number | string, origin = 0): Expr {
+    let unit = BUCKET_RAW;
+    let n = width as number;
+    if (typeof width === 'string') {
+        const m = /^(\d+)(us|ms|s|mo|m|h|d|w|q|y)$/.exec(width);
+        if (!m) throw new TypeError(`timeBucket: bad width: ${width}`);
+        const [u, scale] = BUCKET_UNITS[m[2]];
+        unit = u;
+        n = Number(m[1]) * scale;
+    }
+    if (!Number.isSafeInteger(n) || n <= 0) throw new TypeError(`timeBucket: bad width: ${width}`);
+    if (!Number.isSafeInteger(origin)) throw new TypeError(`timeBucket: bad origin: ${origin}`);
+    const arg = typeof expr === 'string' ? col(expr) : expr;
+    return call('time_bucket', [arg, lit(n), lit(origin)], unit);
+}
+
 function wrap(x: Expr | number | string | boolean): Expr {
     return x instanceof Expr ? x : lit(x);
 }
@@ -74,3 +186,13 @@ function wrap(x: Expr | number | string | boolean): Expr {
 function binop(op: string, left: Expr, right: Expr): Expr {
     return new Expr('binop', { op, left, right });
 }
+
+function call(fn: string, args: Expr[], opt?: number): Expr {
+    return new Expr('call', opt === undefined ? { fn, args } : { fn, args, opt });
+}
+
+function dateField(field: string): number {
+    const code = DATE_FIELDS[field];
+    if (code === undefined) throw new TypeError(`unknown date field: ${field}`);
+    return code;
+}
@@ -1,5 +1,16 @@
-export { Context } from './context';
-export { Expr, col, lit } from './expr';
+export { Context, unpublish } from './context';
+export type { ContextOptions } from './context';
+export { Expr, col, lit, ifElse, concat, timeBucket } from './expr';
+export type { DateField, QuantileOptions } from './expr';
 export { Table } from './table';
+export type { CsvWriteOptions } from './table';
 export { Series } from './series';
 export { Query } from './query';
+export { MaterializedView } from './mview';
+export type { CollectOptions, CollectSyncOptions, GroupKey } from './query';
+export { formatPlan } from './explain';
+export type { PlanNode, PlanProfile } from './explain';
+export type {
+    CacheStats, ContextStats, HeapStats, PoolStats, QueueStats, SymbolStats, WorkerStats,
+} from './stats';
+export type { CancelOptions, SyncCancelOptions } from './cancel';
@@ -0,0 +1,25 @@
+import { Table } from './table';
+
+/** A group-by kept current as rows are appended to its table: each
+ *  `append()` folds only the new rows into per-group partial aggregates.
+ *  Created with `table.groupBy(...keys).materialize(...aggs)`. */
+export class MaterializedView {
+    /** @internal */
+    constructor(
+        private _native: any,
+        private readonly _ctx: any,
+    ) {}
+
+    /** The current aggregation, with the same columns as the equivalent
+     *  `groupBy(...).agg(...)` query. Groups are in first-seen order. */
+    collectSync(): Table {
+        if (!this._native) throw new Error('Materialized view has been dropped');
+        return new Table(this._native.collectSync(), this._ctx);
+    }
+
+    /** Stop maintaining the view and free its state. */
+    drop(): void {
+        this._native?.drop();
+        this._native = null;
+    }
+}
@@ -1,14 +1,34 @@
-import { Expr } from './expr';
+import { Expr, col } from './expr';
 import { Table, GroupBy } from './table';
+import { MaterializedView } from './mview';
+import { CancelOptions, SyncCancelOptions, runCancellable, runSync } from './cancel';
+import { formatPlan } from './explain';
 import path from 'path';
 
 const addon = require(path.join(__dirname, '..', 'build', 'Release', 'teidedb_addon.node'));
 
+export interface CollectOptions extends CancelOptions {
+    /** Record per-node timings, rows, memory and execution paths;
+     *  available afterwards as `table.profile`. */
+    profile?: boolean;
+    /** Set to false to run the query even when the context's result cache
+     *  holds its result. Profiled runs always execute. */
+    cache?: boolean;
+}
+
+export interface CollectSyncOptions extends SyncCancelOptions {
+    profile?: boolean;
+    cache?: boolean;
+}
+
 interface Op {
     type: string;
     [key: string]: any;
 }
 
+/** A group-by key: a column name or a computed expression. */
+export type GroupKey = string | Expr;
+
 export class Query {
     private _ops: Op[] = [];
 
@@ -23,16 +43,52 @@ export class Query {
         return this;
     }
 
-    groupBy(...cols: string[]): GroupBy {
-        return new GroupBy(this, cols);
+    /** Keep only `exprs` as columns; computed columns need an alias. */
+    select(...exprs: Array<Expr | string>): Query {
+        this._ops.push({ type: 'select', exprs: exprs.map(asColumn) });
+        return this;
+    }
+
+    /** Add computed columns, replacing any input column of the same name. */
+    withColumns(...exprs: Expr[]): Query {
+        this._ops.push({ type: 'withColumns', exprs });
+        return this;
+    }
+
+    /** Group by columns or computed keys. A computed key is named by its
+     *  alias; a timeBucket() of a column is named after that column. */
+    groupBy(...keys: GroupKey[]): GroupBy {
+        return new GroupBy(this, keys);
     }
 
     /** @internal */
-    _addGroupOp(keys: string[], aggs: Expr[]): Query {
-        this._ops.push({ type: 'group', keys, aggs });
+    _addGroupOp(keys: GroupKey[], aggs: Expr[]): Query {
+        const op: Op = { type: 'group', keys: keys.map(keyName), aggs };
+        if (keys.some((k) => k instanceof Expr)) {
+            op.keyExprs = keys.map((k) => (k instanceof Expr ? k : null));
+        }
+        this._ops.push(op);
         return this;
     }
 
+    /** @internal */
+    _materialize(keys: GroupKey[], aggs: Expr[]): MaterializedView {
+        if (this._ops.length > 0) {
+            throw new Error('materialize() must be called on a table, not a query');
+        }
+        if (keys.some((k) => typeof k !== 'string')) {
+            throw new Error('materialize() supports only column group keys');
+        }
+        const specs = aggs.map((e) => {
+            const arg = e.params.arg as Expr | undefined;
+            if (e.kind !== 'agg' || arg?.kind !== 'col') {
+                throw new Error('materialize() supports only col(name).<agg>() aggregations');
+            }
+            return { op: e.params.op as number, col: arg.params.name as string };
+        });
+        return new MaterializedView(this._nativeTable.materialize(keys as string[], specs), this._ctx);
+    }
+
     sort(col: string, opts?: { descending?: boolean }): Query {
         this._ops.push({
             type: 'sort',
@@ -47,13 +103,44 @@ export class Query {
         return this;
     }
 
-    collectSync(): Table {
-        const result = addon.collectSync(this._nativeTable, this._ops);
+    collectSync(opts?: CollectSyncOptions): Table {
+        const result = runSync(opts, (o) =>
+            addon.collectSync(this._nativeTable, this._ops, { ...o, profile: opts?.profile, cache: opts?.cache }));
         return new Table(result, this._ctx);
     }
 
-    async collect(): Promise<Table> {
-        const result = await addon.collect(this._nativeTable, this._ops);
+    async collect(opts?: CollectOptions): Promise<Table> {
+        const result = await runCancellable(opts, (o) =>
+            addon.collect(this._nativeTable, this._ops, { ...o, profile: opts?.profile, cache: opts?.cache }));
         return new Table(result, this._ctx);
     }
+
+    /** @internal Source table, context and plan steps, for collectMany(). */
+    _plan(): { table: any; ctx: any; ops: Op[] } {
+        return { table: this._nativeTable, ctx: this._ctx, ops: this._ops };
+    }
+
+    /** The optimized plan as text. With `analyze`, the query is run and
+     *  each node is annotated with its measured profile. */
+    explain(opts?: { analyze?: boolean }): string {
+        if (opts?.analyze) {
+            const t = this.collectSync({ profile: true });
+            return formatPlan(t.profile!);
+        }
+        return formatPlan(addon.explain(this._nativeTable, this._ops));
+    }
+}
+
+function asColumn(e: Expr | string): Expr {
+    return typeof e === 'string' ? col(e) : e;
+}
+
+function keyName(k: GroupKey): string {
+    if (typeof k === 'string') return k;
+    if (k.kind === 'alias') return k.params.name as string;
+    const arg = (k.params.args as Expr[] | undefined)?.[0];
+    if (k.kind === 'call' && k.params.fn === 'time_bucket' && arg?.kind === 'col') {
+        return arg.params.name as string;
+    }
+    throw new TypeError('groupBy: a computed key needs an alias');
 }
@@ -1,33 +1,57 @@
+// Map numeric dtype codes to human-readable strings
+// Values from vendor/teide/include/teide/td.h
+const DTYPE_NAMES: Record<number, string> = {
+    1: 'bool',       // TD_BOOL
+    2: 'u8',         // TD_U8
+    3: 'char',       // TD_CHAR
+    4: 'i16',        // TD_I16
+    5: 'i32',        // TD_I32
+    6: 'i64',        // TD_I64
+    7: 'f64',        // TD_F64
+    9: 'date',       // TD_DATE
+    10: 'time',      // TD_TIME
+    11: 'timestamp', // TD_TIMESTAMP
+    12: 'guid',      // TD_GUID
+    13: 'table',     // TD_TABLE
+    20: 'sym',       // TD_SYM
+};
+
+/** @internal */
+export function dtypeName(d: number): string {
+    return DTYPE_NAMES[d] ?? `unknown(${d})`;
+}
+
+/** @internal */
+export function dtypeCode(name: string): number {
+    for (const [code, n] of Object.entries(DTYPE_NAMES)) {
+        if (n === name) return Number(code);
+    }
+    throw new TypeError(`unknown dtype: ${name}`);
+}
+
 export class Series {
     /** @internal */
     constructor(private readonly _native: any) {}
 
-    get dtype(): string {
-        const d = this._native.dtype;
-        // Map numeric dtype codes to human-readable strings
-        // Values from vendor/teide/include/teide/td.h
-        const map: Record<number, string> = {
-            1: 'bool',       // TD_BOOL
-            2: 'u8',         // TD_U8
-            3: 'char',       // TD_CHAR
-            4: 'i16',        // TD_I16
-            5: 'i32',        // TD_I32
-            6: 'i64',        // TD_I64
-            7: 'f64',        // TD_F64
-            9: 'date',       // TD_DATE
-            10: 'time',      // TD_TIME
-            11: 'timestamp', // TD_TIMESTAMP
-            12: 'guid',      // TD_GUID
-            20: 'sym',       // TD_SYM
-        };
-        return map[d] ?? `unknown(${d})`;
-    }
+    get dtype(): string { return dtypeName(this._native.dtype); }
     get length(): number { return this._native.length; }
     get name(): string { return this._native.name; }
+    /** The column's values, viewed in place (zero-copy). A result served
+     *  by or stored in the context's result cache gets a copy instead, so
+     *  that writes stay private to the caller. */
     get data(): Float64Array | BigInt64Array | Int32Array | Int16Array | Uint8Array {
         return this._native.data;
     }
     get nullBitmap(): Uint8Array | null { return this._native.nullBitmap; }
+    /** Symbol columns: each row's position in `dictionary`. */
     get indices(): Uint8Array | Uint16Array | Uint32Array { return this._native.indices; }
+    /** Symbol columns: the column's distinct values in first-seen order. */
     get dictionary(): string[] { return this._native.dictionary; }
+    /** Symbol columns: `dictionary` as UTF-8, without creating JS strings.
+     *  Entry i is `bytes.subarray(offsets[i], offsets[i + 1])`. The distinct
+     *  values are packed once into `bytes` (they are not contiguous in the
+     *  engine's symbol table); rows are never copied. */
+    get dictionaryBuffer(): { bytes: Uint8Array; offsets: Int32Array } {
+        return this._native.dictionaryBuffer;
+    }
 }
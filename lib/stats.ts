@@ -0,0 +1,86 @@
+/** Occupancy of one engine thread heap. `inUseBytes` counts live blocks
+ *  regardless of which thread frees them; the counters below it are the
+ *  owning thread's own alloc/free tallies. */
+export interface HeapStats {
+    heapId: number;
+    pools: number;
+    poolBytes: number;
+    inUseBytes: number;
+    freeBytes: number;
+    freeBlocks: number;
+    slabBytes: number;
+    slabBlocks: number;
+    foreignBlocks: number;   // freed here, waiting to go back to their owner
+    allocCount: number;
+    freeCount: number;
+    bytesAllocated: number;
+    peakBytes: number;
+    slabHits: number;
+    directCount: number;
+    directBytes: number;
+}
+
+export interface WorkerStats {
+    tasks: number;
+    busyMs: number;
+    utilization: number;     // busyMs / pool.parallelMs
+    cpu: number | null;      // pinned CPU
+    node: number | null;     // NUMA node its heap is bound to
+    heap?: HeapStats;        // absent for index 0, the query thread (see `heap`)
+}
+
+export interface PoolStats {
+    workers: number;         // background threads; the query thread also runs tasks
+    numaNodes: number;       // nodes morsels are split across, 0 when not NUMA-aware
+    dispatches: number;
+    tasks: number;
+    uptimeMs: number;
+    parallelMs: number;      // wall time spent inside parallel dispatches
+    utilization: number;     // busy time / (parallelMs * threads)
+}
+
+export interface SymbolStats {
+    count: number;
+    bytes: number;
+    indexBytes: number;
+}
+
+export interface QueueStats {
+    depth: number;
+    items: { waitMs: number }[];                   // oldest first
+    running: { waitMs: number; runMs: number } | null;
+    completed: number;
+    cancelled: number;
+    avgWaitMs: number;
+    maxWaitMs: number;
+    avgRunMs: number;
+    maxRunMs: number;
+}
+
+export interface CacheStats {
+    entries: number;
+    bytes: number;          // heap bytes held by cached results
+    maxBytes: number;
+    hits: number;
+    misses: number;
+    evictions: number;
+}
+
+/** Snapshot returned by `Context.stats()`.
+ *
+ *  `queue` is always current. The engine figures are read on the query
+ *  thread and only refreshed when it is idle, so a scrape never waits
+ *  behind a running query; `engineAgeMs` says how old they are. They are
+ *  missing until the first idle refresh. The worker pool and symbol table
+ *  are process-wide and shared by all contexts. */
+export interface ContextStats {
+    heap?: HeapStats;
+    sysBytes?: number;
+    sysPeakBytes?: number;
+    pool?: PoolStats;
+    workers?: WorkerStats[];
+    symbols?: SymbolStats;
+    engineAgeMs?: number;
+    queue: QueueStats;
+    cache: CacheStats | null;   // null without `resultCacheBytes`
+}
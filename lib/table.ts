@@ -1,6 +1,16 @@
 import { Series } from './series';
-import { Query } from './query';
+import { Query, GroupKey } from './query';
 import { Expr } from './expr';
+import { PlanProfile } from './explain';
+import type { MaterializedView } from './mview';
+import { CancelOptions, SyncCancelOptions, runCancellable, runSync } from './cancel';
+
+export interface CsvWriteOptions {
+    /** Field separator (default `,`). */
+    delimiter?: string;
+    /** Write the column names as the first line (default: true). */
+    header?: boolean;
+}
 
 export class Table {
     /** @internal */
@@ -12,6 +22,8 @@ export class Table {
     get nRows(): number { return this._native.nRows; }
     get nCols(): number { return this._native.nCols; }
     get columns(): string[] { return this._native.columns; }
+    /** Execution profile, when collected with `{ profile: true }`. */
+    get profile(): PlanProfile | undefined { return this._native.profile; }
 
     col(name: string): Series {
         return new Series(this._native.col(name));
@@ -21,8 +33,16 @@ export class Table {
         return new Query(this._native, this._ctx).filter(expr);
     }
 
-    groupBy(...cols: string[]): GroupBy {
-        return new Query(this._native, this._ctx).groupBy(...cols);
+    select(...exprs: Array<Expr | string>): Query {
+        return new Query(this._native, this._ctx).select(...exprs);
+    }
+
+    withColumns(...exprs: Expr[]): Query {
+        return new Query(this._native, this._ctx).withColumns(...exprs);
+    }
+
+    groupBy(...keys: GroupKey[]): GroupBy {
+        return new Query(this._native, this._ctx).groupBy(...keys);
     }
 
     sort(col: string, opts?: { descending?: boolean }): Query {
@@ -32,16 +52,116 @@ export class Table {
     head(n: number): Query {
         return new Query(this._native, this._ctx).head(n);
     }
+
+    /** Append the rows of `batch`, which must have the same columns and
+     *  types (in any order). Columns grow in place when nothing else shares
+     *  them, so repeated small appends stay cheap; queries started earlier
+     *  keep seeing the rows they started with. Materialized views of this
+     *  table are updated from the new rows alone. */
+    append(batch: Table): this {
+        this._native.append(batch._native);
+        return this;
+    }
+
+    /** Publish a read-only snapshot of this table for other contexts and
+     *  worker_threads of this process, and return its handle: a string
+     *  that can be posted to a worker and passed to `Context.openShared()`.
+     *  Rows in this context's heap are copied once into memory no heap
+     *  owns; columns mapped from files are shared as they are. The
+     *  snapshot lives until `unpublish(handle)` and every table opened
+     *  from it are gone. Later appends to this table are not seen. */
+    publish(): string {
+        return this._native.publish();
+    }
+
+    /** Write the table as CSV, to a file path or a writable stream.
+     *  Rows are formatted in parallel blocks and emitted in order; a stream
+     *  gets one chunk per block, with its backpressure honored. A stream
+     *  export runs in slices, so other queries on the context are not held
+     *  up by a slow consumer. The stream is not ended. Nulls are written as
+     *  empty fields. */
+    writeCsv(dest: string | NodeJS.WritableStream,
+             opts?: CsvWriteOptions & CancelOptions): Promise<void> {
+        const { signal, timeoutMs, ...csv } = opts ?? {};
+        return runCancellable({ signal, timeoutMs }, (o) =>
+            typeof dest === 'string'
+                ? this._native.writeCsv(dest, { ...csv, ...o })
+                : writeCsvStream(this._native, dest, { ...csv, ...o }, { signal, timeoutMs }));
+    }
+
+    writeCsvSync(filePath: string, opts?: CsvWriteOptions & SyncCancelOptions): void {
+        const { timeoutMs, ...csv } = opts ?? {};
+        runSync({ timeoutMs }, (o) => this._native.writeCsvSync(filePath, { ...csv, ...o }));
+    }
+}
+
+function writeCsvStream(native: any, stream: NodeJS.WritableStream,
+                        opts: object, cancel: CancelOptions): Promise<void> {
+    // Native queues the next slice of rows only once every chunk it handed
+    // over was taken; a chunk the stream could not take is resumed on
+    // 'drain'. Cancelling while waiting for 'drain' gives up the wait, which
+    // the native side reports as a cancellation.
+    let failure: unknown;
+    let waiting: Array<(ok: boolean) => void> = [];
+    const settle = (ok: boolean) => {
+        const resumes = waiting;
+        waiting = [];
+        for (const resume of resumes) resume(ok);
+    };
+    const onDrain = () => settle(true);
+    const onError = (e: unknown) => {
+        failure ??= e;
+        settle(false);
+    };
+    const onClose = () => onError(new Error('Stream closed before the CSV write finished'));
+    const onCancel = () => settle(false);
+    stream.on('drain', onDrain);
+    stream.on('error', onError);
+    stream.on('close', onClose);
+    cancel.signal?.addEventListener('abort', onCancel, { once: true });
+    const timer = cancel.timeoutMs !== undefined
+        ? setTimeout(onCancel, cancel.timeoutMs)
+        : undefined;
+    const cleanup = () => {
+        settle(false);
+        clearTimeout(timer);
+        cancel.signal?.removeEventListener('abort', onCancel);
+        stream.removeListener('drain', onDrain);
+        stream.removeListener('error', onError);
+        stream.removeListener('close', onClose);
+    };
+
+    const onChunk = (chunk: Buffer, resume: (ok: boolean) => void): boolean => {
+        try {
+            if (failure === undefined && stream.write(chunk)) return true;
+        } catch (e) {
+            failure ??= e;
+        }
+        if (failure !== undefined) resume(false);
+        else waiting.push(resume);
+        return false;
+    };
+    return native.writeCsvStream(onChunk, opts).then(cleanup, (e: unknown) => {
+        cleanup();
+        throw failure ?? e;
+    });
 }
 
 export class GroupBy {
     /** @internal */
     constructor(
         private readonly _query: Query,
-        private readonly _keys: string[],
+        private readonly _keys: GroupKey[],
     ) {}
 
     agg(...exprs: Expr[]): Query {
         return this._query._addGroupOp(this._keys, exprs);
     }
+
+    /** Keep this aggregation up to date as rows are appended to the table,
+     *  instead of recomputing it. Only plain `col(name).<agg>()`
+     *  aggregations directly on a table are supported. */
+    materialize(...exprs: Expr[]): MaterializedView {
+        return this._query._materialize(this._keys, exprs);
+    }
 }
@@ -1,19 +1,29 @@
 // context.h pulls in teide_thread.h -> <napi.h> and C++ headers.
 // series.h and table.h also pull in teide_thread.h -> <napi.h>.
-// query.h also pulls in teide_thread.h -> <napi.h>.
+// query.h, cancel.h and mview.h also pull in teide_thread.h -> <napi.h>.
 // compat.h with its C-atomic shim must come after all C++ headers.
 #include "context.h"
 #include "series.h"
 #include "table.h"
 #include "query.h"
+#include "cancel.h"
+#include "mview.h"
+#include "addon_data.h"
 #include "compat.h"
 
 Napi::Object Init(Napi::Env env, Napi::Object exports) {
+    env.SetInstanceData(new AddonData());
     NativeContext::Init(env, exports);
     NativeSeries::Init(env, exports);
     NativeTable::Init(env, exports);
+    NativeCancelToken::Init(env, exports);
+    NativeMView::Init(env, exports);
     exports.Set("collectSync", Napi::Function::New(env, QueryCollectSync));
     exports.Set("collect", Napi::Function::New(env, QueryCollect));
+    exports.Set("explain", Napi::Function::New(env, QueryExplain));
+    exports.Set("collectManySync", Napi::Function::New(env, QueryCollectManySync));
+    exports.Set("collectMany", Napi::Function::New(env, QueryCollectMany));
+    exports.Set("unpublish", Napi::Function::New(env, TableUnpublish));
     return exports;
 }
 
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <napi.h>
+
+// Per-environment state. The addon is loaded once per process but
+// initialized once per Node environment -- the main thread and every
+// worker_thread -- and a constructor reference only works in the
+// environment that created it, so none of this may live in statics.
+struct AddonData {
+    Napi::FunctionReference table;
+    Napi::FunctionReference series;
+    Napi::FunctionReference mview;
+    Napi::FunctionReference cancel_token;
+
+    static AddonData& Of(Napi::Env env) { return *env.GetInstanceData<AddonData>(); }
+};
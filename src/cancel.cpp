@@ -0,0 +1,54 @@
+// cancel.h MUST come first -- it pulls in teide_thread.h which brings
+// <napi.h>, <atomic>, and other C++ headers before the C-atomic shim.
+#include "cancel.h"
+#include "addon_data.h"
+#include "compat.h"
+
+
+Napi::Object NativeCancelToken::Init(Napi::Env env, Napi::Object exports) {
+    Napi::Function func = DefineClass(env, "NativeCancelToken", {
+        InstanceMethod("cancel", &NativeCancelToken::Cancel),
+        InstanceAccessor("cancelled", &NativeCancelToken::GetCancelled, nullptr),
+    });
+    AddonData::Of(env).cancel_token = Napi::Persistent(func);
+    exports.Set("NativeCancelToken", func);
+    return exports;
+}
+
+NativeCancelToken::NativeCancelToken(const Napi::CallbackInfo& info)
+    : Napi::ObjectWrap<NativeCancelToken>(info) {}
+
+Napi::Value NativeCancelToken::Cancel(const Napi::CallbackInfo& info) {
+    token_->cancel();
+    return info.Env().Undefined();
+}
+
+Napi::Value NativeCancelToken::GetCancelled(const Napi::CallbackInfo& info) {
+    return Napi::Boolean::New(info.Env(), token_->cancelled.load());
+}
+
+std::shared_ptr<CancelToken> CancelTokenFromOpts(Napi::Value opts) {
+    if (!opts.IsObject()) return nullptr;
+    Napi::Object o = opts.As<Napi::Object>();
+
+    std::shared_ptr<CancelToken> token;
+    Napi::Value t = o.Get("token");
+    if (t.IsObject() &&
+        t.As<Napi::Object>().InstanceOf(AddonData::Of(opts.Env()).cancel_token.Value())) {
+        token = Napi::ObjectWrap<NativeCancelToken>::Unwrap(
+            t.As<Napi::Object>())->token();
+    }
+
+    // Non-finite or absurdly large timeouts mean "no deadline" (and would
+    // overflow the clock arithmetic below).
+    Napi::Value ms = o.Get("timeoutMs");
+    double v = ms.IsNumber() ? ms.As<Napi::Number>().DoubleValue() : -1;
+    if (ms.IsNumber() && v < 1e12) {
+        if (!token) token = std::make_shared<CancelToken>();
+        if (!(v > 0)) v = 0;
+        token->deadline = CancelToken::Clock::now() +
+            std::chrono::duration_cast<CancelToken::Clock::duration>(
+                std::chrono::duration<double, std::milli>(v));
+    }
+    return token;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+// teide_thread.h pulls in <napi.h> and C++ standard headers.
+// These must come before compat.h's C-atomic shim.
+#include "teide_thread.h"
+
+// JS handle for a CancelToken. lib/ creates one per cancellable call and
+// wires AbortSignal / timeouts to cancel().
+class NativeCancelToken : public Napi::ObjectWrap<NativeCancelToken> {
+public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports);
+    NativeCancelToken(const Napi::CallbackInfo& info);
+
+    std::shared_ptr<CancelToken> token() const { return token_; }
+
+private:
+    Napi::Value Cancel(const Napi::CallbackInfo& info);
+    Napi::Value GetCancelled(const Napi::CallbackInfo& info);
+
+    std::shared_ptr<CancelToken> token_ = std::make_shared<CancelToken>();
+
+    friend std::shared_ptr<CancelToken> CancelTokenFromOpts(Napi::Value opts);
+};
+
+// Resolve the `{ token?, timeoutMs? }` options object passed by lib/ into the
+// CancelToken for one dispatch. Returns nullptr when neither is present.
+// Runs on the V8 thread.
+std::shared_ptr<CancelToken> CancelTokenFromOpts(Napi::Value opts);
@@ -2,21 +2,190 @@
 // <napi.h>, <atomic>, and other C++ headers before the C-atomic shim.
 #include "context.h"
 #include "table.h"
+#include "cancel.h"
+#include "result_cache.h"
 #include "compat.h"
 
+#include <algorithm>
+#include <vector>
+
+struct EngineSnapshot {
+    td_heap_stats_t heap;
+    td_sym_stats_t sym;
+    td_pool_stats_t pool;
+    std::vector<td_pool_worker_stats_t> workers;
+    std::chrono::steady_clock::time_point taken;
+};
+
 Napi::Object NativeContext::Init(Napi::Env env, Napi::Object exports) {
     Napi::Function func = DefineClass(env, "NativeContext", {
         InstanceMethod("destroy", &NativeContext::Destroy),
         InstanceMethod("readCsvSync", &NativeContext::ReadCsvSync),
         InstanceMethod("readCsv", &NativeContext::ReadCsv),
+        InstanceMethod("openShared", &NativeContext::OpenShared),
+        InstanceMethod("stats", &NativeContext::Stats),
     });
     exports.Set("NativeContext", func);
     return exports;
 }
 
+// Worker pool options: { threads?, cpus?, pin?, numa? }. The pool is
+// process-wide; the first context that passes options creates it and later
+// contexts must agree on the thread count.
+static void ConfigurePool(Napi::Env env, TeideThread& thr, Napi::Object opts) {
+    std::vector<uint16_t> cpus;
+    uint32_t threads = 0;
+    bool pin = false;
+    bool numa = true;
+    bool any = false;
+
+    Napi::Value v = opts.Get("threads");
+    if (!v.IsUndefined()) {
+        double n = v.IsNumber() ? v.As<Napi::Number>().DoubleValue() : 0;
+        if (!(n >= 1 && n <= 4096) || n != (double)(uint32_t)n) {
+            Napi::RangeError::New(env, "threads must be a positive integer")
+                .ThrowAsJavaScriptException();
+            return;
+        }
+        threads = (uint32_t)n;
+        any = true;
+    }
+    v = opts.Get("cpus");
+    if (!v.IsUndefined()) {
+        if (!v.IsArray()) {
+            Napi::TypeError::New(env, "cpus must be an array of CPU ids")
+                .ThrowAsJavaScriptException();
+            return;
+        }
+        Napi::Array arr = v.As<Napi::Array>();
+        for (uint32_t i = 0; i < arr.Length(); i++) {
+            Napi::Value c = arr.Get(i);
+            double id = c.IsNumber() ? c.As<Napi::Number>().DoubleValue() : -1;
+            if (!(id >= 0 && id < 65536) || id != (double)(uint32_t)id) {
+                Napi::RangeError::New(env, "cpus must be an array of CPU ids")
+                    .ThrowAsJavaScriptException();
+                return;
+            }
+            cpus.push_back((uint16_t)id);
+        }
+        // Reject CPUs outside the process affinity up front: the pool would
+        // refuse them anyway, with a less helpful error.
+        std::vector<uint16_t> allowed(td_cpu_list(nullptr, 0));
+        allowed.resize(std::min<size_t>(allowed.size(),
+                                        td_cpu_list(allowed.data(), (uint32_t)allowed.size())));
+        for (uint16_t c : cpus) {
+            if (std::find(allowed.begin(), allowed.end(), c) == allowed.end()) {
+                Napi::RangeError::New(env, "cpus: CPU " + std::to_string(c) +
+                    " is not available to this process")
+                    .ThrowAsJavaScriptException();
+                return;
+            }
+        }
+        pin = !cpus.empty();
+        any = true;
+    }
+    v = opts.Get("pin");
+    if (v.IsBoolean()) { pin = v.As<Napi::Boolean>().Value(); any = true; }
+    v = opts.Get("numa");
+    if (v.IsBoolean()) numa = v.As<Napi::Boolean>().Value();
+    if (!any) return;
+
+    td_pool_opts_t po;
+    po.n_threads = threads;
+    po.cpus = cpus.empty() ? nullptr : cpus.data();
+    po.n_cpus = (uint32_t)cpus.size();
+    po.flags = (pin ? TD_POOL_PIN : 0) | (pin && numa ? TD_POOL_NUMA : 0);
+
+    td_err_t err = TD_OK;
+    uint32_t running = 0;
+    thr.dispatch_sync([&]() -> void* {
+        td_pool_stats_t ps;
+        if (td_pool_stats(&ps, nullptr, 0)) running = ps.n_workers + 1;
+        else err = td_pool_init_ex(&po);
+        return nullptr;
+    });
+
+    if (err != TD_OK && pin && (err == TD_ERR_IO || err == TD_ERR_NYI)) {
+        Napi::Error::New(env, err == TD_ERR_NYI
+            ? "CPU pinning is not supported on this platform"
+            : "Failed to pin worker pool threads to their CPUs")
+            .ThrowAsJavaScriptException();
+    } else if (err != TD_OK) {
+        Napi::Error::New(env, std::string("Failed to start worker pool: ") + td_err_str(err))
+            .ThrowAsJavaScriptException();
+    } else if (running && threads && running != threads) {
+        Napi::Error::New(env, "Worker pool is already running with " +
+            std::to_string(running) + " threads")
+            .ThrowAsJavaScriptException();
+    }
+}
+
+// Heap page options: { hugePages?: boolean | 'explicit', prefault?,
+// warmReserveBytes? }. Process-wide like the pool; the last context that
+// passes any of them sets all three.
+static void ConfigureHeap(Napi::Env env, Napi::Object opts) {
+    td_heap_opts_t ho = {0, 0};
+    bool any = false;
+
+    Napi::Value v = opts.Get("hugePages");
+    if (!v.IsUndefined()) {
+        if (v.IsBoolean()) {
+            if (v.As<Napi::Boolean>().Value()) ho.flags |= TD_HEAP_HUGE;
+        } else if (v.IsString() && v.As<Napi::String>().Utf8Value() == "explicit") {
+            ho.flags |= TD_HEAP_HUGETLB;
+        } else {
+            Napi::TypeError::New(env, "hugePages must be a boolean or 'explicit'")
+                .ThrowAsJavaScriptException();
+            return;
+        }
+        any = true;
+    }
+    v = opts.Get("prefault");
+    if (v.IsBoolean()) {
+        if (v.As<Napi::Boolean>().Value()) ho.flags |= TD_HEAP_PREFAULT;
+        any = true;
+    }
+    v = opts.Get("warmReserveBytes");
+    if (!v.IsUndefined()) {
+        double n = v.IsNumber() ? v.As<Napi::Number>().DoubleValue() : -1;
+        if (!(n >= 0 && n <= 9007199254740991.0)) {
+            Napi::RangeError::New(env, "warmReserveBytes must be a non-negative number")
+                .ThrowAsJavaScriptException();
+            return;
+        }
+        ho.reserve_bytes = (size_t)n;
+        any = true;
+    }
+    if (any) td_heap_configure(&ho);
+}
+
+// { resultCacheBytes? }: heap budget of the query result cache; 0 or
+// absent leaves it off.
+static std::unique_ptr<ResultCache> ConfigureCache(Napi::Env env, Napi::Object opts) {
+    Napi::Value v = opts.Get("resultCacheBytes");
+    if (v.IsUndefined()) return nullptr;
+    double n = v.IsNumber() ? v.As<Napi::Number>().DoubleValue() : -1;
+    if (!(n >= 0 && n <= 9007199254740991.0)) {
+        Napi::RangeError::New(env, "resultCacheBytes must be a non-negative number")
+            .ThrowAsJavaScriptException();
+        return nullptr;
+    }
+    if (n < 1) return nullptr;
+    return std::make_unique<ResultCache>((size_t)n);
+}
+
 NativeContext::NativeContext(const Napi::CallbackInfo& info)
     : Napi::ObjectWrap<NativeContext>(info) {
     thread_ = std::make_unique<TeideThread>();
+    if (info.Length() > 0 && info[0].IsObject()) {
+        Napi::Object opts = info[0].As<Napi::Object>();
+        ConfigurePool(info.Env(), *thread_, opts);
+        if (info.Env().IsExceptionPending()) return;
+        ConfigureHeap(info.Env(), opts);
+        if (info.Env().IsExceptionPending()) return;
+        cache_ = ConfigureCache(info.Env(), opts);
+        thread_->set_result_cache(cache_.get());
+    }
 }
 
 NativeContext::~NativeContext() {
@@ -48,9 +217,10 @@ Napi::Value NativeContext::ReadCsvSync(const Napi::CallbackInfo& info) {
     }
 
     std::string path = info[0].As<Napi::String>().Utf8Value();
+    auto token = CancelTokenFromOpts(info[1]);
     void* result = thread_->dispatch_sync([path]() -> void* {
         return (void*)td_read_csv(path.c_str());
-    });
+    }, token);
 
     td_t* tbl = (td_t*)result;
     if (TD_IS_ERR(tbl)) {
@@ -74,6 +244,7 @@ Napi::Value NativeContext::ReadCsv(const Napi::CallbackInfo& info) {
     }
 
     std::string path = info[0].As<Napi::String>().Utf8Value();
+    auto token = CancelTokenFromOpts(info[1]);
     auto deferred = Napi::Promise::Deferred::New(env);
     auto tsfn = Napi::ThreadSafeFunction::New(env, Napi::Function(), "readCsv", 0, 1);
 
@@ -89,8 +260,172 @@ Napi::Value NativeContext::ReadCsv(const Napi::CallbackInfo& info) {
             } else {
                 deferred.Resolve(NativeTable::Create(env, (td_t*)data, thr));
             }
-        }
+        },
+        token
     );
 
     return deferred.Promise();
 }
+
+// A published table is opened by reference: no copy and no work for the
+// Teide thread. Its symbol IDs are valid here because the symbol table is
+// process-wide.
+Napi::Value NativeContext::OpenShared(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    check_alive(env);
+    if (env.IsExceptionPending()) return env.Undefined();
+
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Expected a shared table handle").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    std::string handle = info[0].As<Napi::String>().Utf8Value();
+    td_t* tbl = SharedTableOpen(handle);
+    if (!tbl) {
+        Napi::Error::New(env, "Unknown shared table handle: " + handle).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    return NativeTable::Create(env, tbl, thread_.get());
+}
+
+// ---------------------------------------------------------------------------
+// Stats
+// ---------------------------------------------------------------------------
+
+static double ns_to_ms(int64_t ns) { return (double)ns / 1e6; }
+
+static Napi::Object HeapStatsToJs(Napi::Env env, const td_heap_stats_t& h) {
+    auto o = Napi::Object::New(env);
+    o.Set("heapId", Napi::Number::New(env, h.heap_id));
+    o.Set("pools", Napi::Number::New(env, h.pool_count));
+    o.Set("poolBytes", Napi::Number::New(env, (double)h.pool_bytes));
+    o.Set("inUseBytes", Napi::Number::New(env, (double)h.in_use_bytes));
+    o.Set("freeBytes", Napi::Number::New(env, (double)h.free_bytes));
+    o.Set("freeBlocks", Napi::Number::New(env, (double)h.free_blocks));
+    o.Set("slabBytes", Napi::Number::New(env, (double)h.slab_bytes));
+    o.Set("slabBlocks", Napi::Number::New(env, (double)h.slab_blocks));
+    o.Set("foreignBlocks", Napi::Number::New(env, (double)h.foreign_blocks));
+    o.Set("allocCount", Napi::Number::New(env, (double)h.mem.alloc_count));
+    o.Set("freeCount", Napi::Number::New(env, (double)h.mem.free_count));
+    o.Set("bytesAllocated", Napi::Number::New(env, (double)h.mem.bytes_allocated));
+    o.Set("peakBytes", Napi::Number::New(env, (double)h.mem.peak_bytes));
+    o.Set("slabHits", Napi::Number::New(env, (double)h.mem.slab_hits));
+    o.Set("directCount", Napi::Number::New(env, (double)h.mem.direct_count));
+    o.Set("directBytes", Napi::Number::New(env, (double)h.mem.direct_bytes));
+    return o;
+}
+
+Napi::Value NativeContext::Stats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    check_alive(env);
+    if (env.IsExceptionPending()) return env.Undefined();
+
+    QueueStats q = thread_->queue_stats();
+
+    // Heap and pool structures may only be read on the Teide thread while
+    // nothing executes there. If it is busy, report the previous snapshot.
+    if (!q.running && q.depth == 0) {
+        auto snap = std::make_unique<EngineSnapshot>();
+        EngineSnapshot* sp = snap.get();
+        thread_->dispatch_probe([sp]() -> void* {
+            td_heap_stats(&sp->heap);
+            td_sym_stats(&sp->sym);
+            td_pool_stats_t ps;
+            uint32_t n = td_pool_stats(&ps, nullptr, 0);
+            sp->workers.resize(n);
+            td_pool_stats(&sp->pool, sp->workers.data(), n);
+            sp->taken = std::chrono::steady_clock::now();
+            return nullptr;
+        });
+        engine_ = std::move(snap);
+    }
+
+    auto out = Napi::Object::New(env);
+
+    if (engine_) {
+        const EngineSnapshot& e = *engine_;
+        out.Set("heap", HeapStatsToJs(env, e.heap));
+        out.Set("sysBytes", Napi::Number::New(env, (double)e.heap.mem.sys_current));
+        out.Set("sysPeakBytes", Napi::Number::New(env, (double)e.heap.mem.sys_peak));
+
+        auto sym = Napi::Object::New(env);
+        sym.Set("count", Napi::Number::New(env, e.sym.count));
+        sym.Set("bytes", Napi::Number::New(env, (double)e.sym.str_bytes));
+        sym.Set("indexBytes", Napi::Number::New(env, (double)e.sym.index_bytes));
+        out.Set("symbols", sym);
+
+        int64_t busy = 0;
+        auto workers = Napi::Array::New(env, e.workers.size());
+        for (size_t i = 0; i < e.workers.size(); i++) {
+            const td_pool_worker_stats_t& w = e.workers[i];
+            busy += w.busy_ns;
+            auto wo = Napi::Object::New(env);
+            wo.Set("tasks", Napi::Number::New(env, (double)w.tasks));
+            wo.Set("busyMs", Napi::Number::New(env, ns_to_ms(w.busy_ns)));
+            wo.Set("utilization", Napi::Number::New(env,
+                e.pool.parallel_ns > 0 ? (double)w.busy_ns / (double)e.pool.parallel_ns : 0.0));
+            wo.Set("cpu", w.cpu >= 0 ? Napi::Number::New(env, w.cpu) : env.Null());
+            wo.Set("node", w.node >= 0 ? Napi::Number::New(env, w.node) : env.Null());
+            if (i > 0) wo.Set("heap", HeapStatsToJs(env, w.heap));
+            workers.Set((uint32_t)i, wo);
+        }
+
+        auto pool = Napi::Object::New(env);
+        pool.Set("workers", Napi::Number::New(env, e.pool.n_workers));
+        pool.Set("numaNodes", Napi::Number::New(env, e.pool.n_nodes));
+        pool.Set("dispatches", Napi::Number::New(env, e.pool.dispatch_count));
+        pool.Set("tasks", Napi::Number::New(env, (double)e.pool.tasks_dispatched));
+        pool.Set("uptimeMs", Napi::Number::New(env, ns_to_ms(e.pool.uptime_ns)));
+        pool.Set("parallelMs", Napi::Number::New(env, ns_to_ms(e.pool.parallel_ns)));
+        double cap = (double)e.pool.parallel_ns * (double)e.workers.size();
+        pool.Set("utilization", Napi::Number::New(env, cap > 0 ? (double)busy / cap : 0.0));
+        out.Set("pool", pool);
+        out.Set("workers", workers);
+
+        std::chrono::duration<double, std::milli> age =
+            std::chrono::steady_clock::now() - e.taken;
+        out.Set("engineAgeMs", Napi::Number::New(env, age.count()));
+    }
+
+    auto queue = Napi::Object::New(env);
+    queue.Set("depth", Napi::Number::New(env, (double)q.depth));
+    auto items = Napi::Array::New(env, q.queued_wait_ms.size());
+    for (size_t i = 0; i < q.queued_wait_ms.size(); i++) {
+        auto it = Napi::Object::New(env);
+        it.Set("waitMs", Napi::Number::New(env, q.queued_wait_ms[i]));
+        items.Set((uint32_t)i, it);
+    }
+    queue.Set("items", items);
+    if (q.running) {
+        auto r = Napi::Object::New(env);
+        r.Set("waitMs", Napi::Number::New(env, q.running_wait_ms));
+        r.Set("runMs", Napi::Number::New(env, q.running_ms));
+        queue.Set("running", r);
+    } else {
+        queue.Set("running", env.Null());
+    }
+    queue.Set("completed", Napi::Number::New(env, (double)q.completed));
+    queue.Set("cancelled", Napi::Number::New(env, (double)q.cancelled));
+    double n = q.completed ? (double)q.completed : 1.0;
+    queue.Set("avgWaitMs", Napi::Number::New(env, q.total_wait_ms / n));
+    queue.Set("maxWaitMs", Napi::Number::New(env, q.max_wait_ms));
+    queue.Set("avgRunMs", Napi::Number::New(env, q.total_run_ms / n));
+    queue.Set("maxRunMs", Napi::Number::New(env, q.max_run_ms));
+    out.Set("queue", queue);
+
+    if (cache_) {
+        ResultCache::Stats c = cache_->stats();
+        auto cache = Napi::Object::New(env);
+        cache.Set("entries", Napi::Number::New(env, (double)c.entries));
+        cache.Set("bytes", Napi::Number::New(env, (double)c.bytes));
+        cache.Set("maxBytes", Napi::Number::New(env, (double)c.max_bytes));
+        cache.Set("hits", Napi::Number::New(env, (double)c.hits));
+        cache.Set("misses", Napi::Number::New(env, (double)c.misses));
+        cache.Set("evictions", Napi::Number::New(env, (double)c.evictions));
+        out.Set("cache", cache);
+    } else {
+        out.Set("cache", env.Null());
+    }
+
+    return out;
+}
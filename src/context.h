@@ -4,6 +4,9 @@
 // These must come before compat.h's C-atomic shim.
 #include "teide_thread.h"
 
+struct EngineSnapshot;
+class ResultCache;
+
 class NativeContext : public Napi::ObjectWrap<NativeContext> {
 public:
     static Napi::Object Init(Napi::Env env, Napi::Object exports);
@@ -17,7 +20,15 @@ private:
     Napi::Value Destroy(const Napi::CallbackInfo& info);
     Napi::Value ReadCsvSync(const Napi::CallbackInfo& info);
     Napi::Value ReadCsv(const Napi::CallbackInfo& info);
+    Napi::Value OpenShared(const Napi::CallbackInfo& info);
+    Napi::Value Stats(const Napi::CallbackInfo& info);
 
     std::unique_ptr<TeideThread> thread_;
+    // Last heap/pool/symbol figures taken on the Teide thread; reused
+    // while a query is running so stats() never waits behind it.
+    std::unique_ptr<EngineSnapshot> engine_;
+    // Present when the context was created with a resultCacheBytes budget.
+    // Cleared by the Teide thread on shutdown, destroyed after it.
+    std::unique_ptr<ResultCache> cache_;
     bool destroyed_ = false;
 };
@@ -0,0 +1,99 @@
+// mview.h MUST come first -- it pulls in teide_thread.h which brings
+// <napi.h>, <atomic>, and other C++ headers before the C-atomic shim.
+#include "mview.h"
+#include "table.h"
+#include "addon_data.h"
+#include "compat.h"
+
+
+// ---------------------------------------------------------------------------
+// MViewState
+// ---------------------------------------------------------------------------
+
+MViewState::~MViewState() {
+    // Accumulators live in td_sys memory, not the Teide heap: safe to free
+    // from the JS thread and after the context is gone.
+    td_mview_free(view);
+}
+
+int MViewState::Build(td_t* tbl) {
+    td_mview_free(view);
+    view = nullptr;
+    td_err_t e = td_mview_new(&view, tbl, key_syms.data(), (uint8_t)key_syms.size(),
+                              agg_ops.data(), agg_syms.data(), (uint8_t)agg_ops.size());
+    err = (int)e;
+    return err;
+}
+
+void MViewState::Apply(td_t* tbl, td_t* batch) {
+    if (view && td_mview_append(view, batch) == TD_OK) return;
+    // A partly folded batch leaves the partials unusable: start over.
+    Build(tbl);
+}
+
+// ---------------------------------------------------------------------------
+// NativeMView
+// ---------------------------------------------------------------------------
+
+Napi::Object NativeMView::Init(Napi::Env env, Napi::Object exports) {
+    Napi::Function func = DefineClass(env, "NativeMView", {
+        InstanceMethod("collectSync", &NativeMView::CollectSync),
+        InstanceMethod("drop", &NativeMView::Drop),
+    });
+    AddonData::Of(env).mview = Napi::Persistent(func);
+    exports.Set("NativeMView", func);
+    return exports;
+}
+
+Napi::Object NativeMView::Create(Napi::Env env, std::shared_ptr<MViewState> state,
+                                 TeideThread* thread) {
+    return AddonData::Of(env).mview.New({
+        Napi::External<std::shared_ptr<MViewState>>::New(env, &state),
+        Napi::External<TeideThread>::New(env, thread),
+    });
+}
+
+NativeMView::NativeMView(const Napi::CallbackInfo& info)
+    : Napi::ObjectWrap<NativeMView>(info), thread_(nullptr) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 2) {
+        Napi::TypeError::New(env, "NativeMView: internal constructor requires 2 arguments")
+            .ThrowAsJavaScriptException();
+        return;
+    }
+    state_ = *info[0].As<Napi::External<std::shared_ptr<MViewState>>>().Data();
+    thread_ = info[1].As<Napi::External<TeideThread>>().Data();
+}
+
+Napi::Value NativeMView::CollectSync(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (!state_) {
+        Napi::Error::New(env, "Materialized view has been dropped").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    if (!thread_->is_running()) {
+        Napi::Error::New(env, "Context has been destroyed").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    std::shared_ptr<MViewState> state = state_;
+    void* result = thread_->dispatch_sync([state]() -> void* {
+        if (!state->view) return TD_ERR_PTR((td_err_t)state->err);
+        return td_mview_result(state->view);
+    });
+
+    td_t* res = (td_t*)result;
+    if (TD_IS_ERR(res)) {
+        Napi::Error::New(env, std::string("Materialized view failed: ") +
+                              td_err_str(TD_ERR_CODE(res))).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    return NativeTable::Create(env, res, thread_);
+}
+
+Napi::Value NativeMView::Drop(const Napi::CallbackInfo& info) {
+    // The table only holds a weak reference: releasing ours unregisters it.
+    // The partials are freed once no append is using them.
+    state_.reset();
+    return info.Env().Undefined();
+}
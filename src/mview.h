@@ -0,0 +1,49 @@
+#pragma once
+
+// teide_thread.h pulls in <napi.h> and C++ standard headers.
+// These must come before compat.h's C-atomic shim.
+#include "teide_thread.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+// Forward-declare C types (defined in td.h, included via compat.h in .cpp files).
+extern "C" {
+    typedef union td_t td_t;
+    typedef struct td_mview td_mview_t;
+}
+
+class TeideThread;
+
+// Engine view plus the spec it was built from, so a view whose incremental
+// update failed can be rebuilt from the whole table. Shared between the JS
+// wrapper, which owns it, and the table it follows, which only holds a
+// weak reference. Touched on the Teide thread only, except for teardown.
+struct MViewState {
+    std::vector<int64_t> key_syms;
+    std::vector<uint16_t> agg_ops;
+    std::vector<int64_t> agg_syms;
+    td_mview_t* view = nullptr;
+    int err = 0;                    // td_err_t of a failed rebuild, 0 if usable
+
+    ~MViewState();
+    // Build the view over `tbl`. Returns the td_err_t.
+    int Build(td_t* tbl);
+    // Fold `batch`, just appended to what is now `tbl`.
+    void Apply(td_t* tbl, td_t* batch);
+};
+
+class NativeMView : public Napi::ObjectWrap<NativeMView> {
+public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports);
+    static Napi::Object Create(Napi::Env env, std::shared_ptr<MViewState> state,
+                               TeideThread* thread);
+    NativeMView(const Napi::CallbackInfo& info);
+
+private:
+    Napi::Value CollectSync(const Napi::CallbackInfo& info);
+    Napi::Value Drop(const Napi::CallbackInfo& info);
+
+    std::shared_ptr<MViewState> state_;
+    TeideThread* thread_;
+};
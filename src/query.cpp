@@ -2,27 +2,79 @@
 // <napi.h>, <atomic>, and other C++ headers before the C-atomic shim.
 #include "query.h"
 #include "table.h"
+#include "cancel.h"
+#include "result_cache.h"
 #include "compat.h"
 
+#include <algorithm>
 #include <stdexcept>
+#include <unordered_map>
 
 // ---------------------------------------------------------------------------
 // Serialization: JS Expr objects -> C++ ExprNode trees (runs on V8 thread)
 // ---------------------------------------------------------------------------
 
+// Names used by lib/ are resolved to codes here, once per collect, so the
+// Teide thread builds the graph with switches rather than string compares.
+struct NameCode {
+    const char* name;
+    uint16_t code;
+};
+
+static const NameCode kExprKinds[] = {
+    {"col", EXPR_COL}, {"lit", EXPR_LIT}, {"binop", EXPR_BINOP}, {"unop", EXPR_UNOP},
+    {"agg", EXPR_AGG}, {"alias", EXPR_ALIAS}, {"in", EXPR_IN}, {"call", EXPR_CALL},
+};
+
+static const NameCode kBinops[] = {
+    {"add", OP_ADD}, {"sub", OP_SUB}, {"mul", OP_MUL}, {"div", OP_DIV},
+    {"mod", OP_MOD}, {"eq", OP_EQ}, {"ne", OP_NE}, {"lt", OP_LT},
+    {"le", OP_LE}, {"gt", OP_GT}, {"ge", OP_GE}, {"and", OP_AND},
+    {"or", OP_OR}, {"min2", OP_MIN2}, {"max2", OP_MAX2}, {"like", OP_LIKE},
+    {"ilike", OP_ILIKE},
+};
+
+static const NameCode kUnops[] = {
+    {"neg", OP_NEG}, {"abs", OP_ABS}, {"not", OP_NOT}, {"sqrt", OP_SQRT},
+    {"log", OP_LOG}, {"exp", OP_EXP}, {"ceil", OP_CEIL}, {"floor", OP_FLOOR},
+    {"isnull", OP_ISNULL}, {"upper", OP_UPPER}, {"lower", OP_LOWER},
+    {"strlen", OP_STRLEN}, {"trim", OP_TRIM},
+};
+
+static const NameCode kCalls[] = {
+    {"if", OP_IF}, {"substr", OP_SUBSTR}, {"replace", OP_REPLACE},
+    {"concat", OP_CONCAT}, {"cast", OP_CAST}, {"extract", OP_EXTRACT},
+    {"date_trunc", OP_DATE_TRUNC}, {"time_bucket", OP_TIME_BUCKET},
+};
+
+static const NameCode kStepTypes[] = {
+    {"filter", STEP_FILTER}, {"group", STEP_GROUP}, {"sort", STEP_SORT},
+    {"head", STEP_HEAD}, {"select", STEP_SELECT}, {"withColumns", STEP_WITH_COLUMNS},
+};
+
+// Code for the string `v`, or 0 when it is not in `table`.
+template <size_t N>
+static uint16_t LookupName(const NameCode (&table)[N], Napi::Value v) {
+    std::string name = v.As<Napi::String>().Utf8Value();
+    for (const auto& e : table)
+        if (name == e.name) return e.code;
+    return 0;
+}
+
 std::shared_ptr<ExprNode> SerializeExpr(Napi::Object expr) {
     auto node = std::make_shared<ExprNode>();
 
     // Read the kind field
-    node->kind = expr.Get("kind").As<Napi::String>().Utf8Value();
+    node->kind = (ExprKind)LookupName(kExprKinds, expr.Get("kind"));
 
     // Read the params object
     Napi::Object params = expr.Get("params").As<Napi::Object>();
 
-    if (node->kind == "col") {
+    switch (node->kind) {
+    case EXPR_COL:
         node->str_val = params.Get("name").As<Napi::String>().Utf8Value();
-    }
-    else if (node->kind == "lit") {
+        break;
+    case EXPR_LIT: {
         Napi::Value val = params.Get("value");
         if (val.IsNumber()) {
             node->lit_type = LIT_NUM;
@@ -34,23 +86,58 @@ std::shared_ptr<ExprNode> SerializeExpr(Napi::Object expr) {
             node->lit_type = LIT_STR;
             node->str_val = val.As<Napi::String>().Utf8Value();
         }
+        break;
     }
-    else if (node->kind == "binop") {
-        node->str_val = params.Get("op").As<Napi::String>().Utf8Value();
+    case EXPR_BINOP:
+        node->opcode = LookupName(kBinops, params.Get("op"));
         node->left = SerializeExpr(params.Get("left").As<Napi::Object>());
         node->right = SerializeExpr(params.Get("right").As<Napi::Object>());
-    }
-    else if (node->kind == "unop") {
-        node->str_val = params.Get("op").As<Napi::String>().Utf8Value();
+        break;
+    case EXPR_UNOP:
+        node->opcode = LookupName(kUnops, params.Get("op"));
         node->left = SerializeExpr(params.Get("arg").As<Napi::Object>());
-    }
-    else if (node->kind == "agg") {
-        node->agg_opcode = params.Get("op").As<Napi::Number>().Int32Value();
+        break;
+    case EXPR_AGG: {
+        node->opcode = (uint16_t)params.Get("op").As<Napi::Number>().Int32Value();
         node->left = SerializeExpr(params.Get("arg").As<Napi::Object>());
+        // Quantile fraction; range is checked in lib/expr.ts
+        Napi::Value q = params.Get("q");
+        if (q.IsNumber()) node->num_val = q.As<Napi::Number>().DoubleValue();
+        break;
     }
-    else if (node->kind == "alias") {
+    case EXPR_ALIAS:
         node->str_val = params.Get("name").As<Napi::String>().Utf8Value();
         node->left = SerializeExpr(params.Get("arg").As<Napi::Object>());
+        break;
+    case EXPR_CALL: {
+        node->opcode = LookupName(kCalls, params.Get("fn"));
+        Napi::Value opt = params.Get("opt");
+        if (opt.IsNumber()) node->num_val = opt.As<Napi::Number>().DoubleValue();
+        Napi::Array args = params.Get("args").As<Napi::Array>();
+        for (uint32_t i = 0; i < args.Length(); i++)
+            node->args.push_back(SerializeExpr(args.Get(i).As<Napi::Object>()));
+        break;
+    }
+    case EXPR_IN: {
+        node->left = SerializeExpr(params.Get("arg").As<Napi::Object>());
+        // Element type is checked in lib/expr.ts; the list is homogeneous
+        Napi::Array values = params.Get("values").As<Napi::Array>();
+        uint32_t n = values.Length();
+        for (uint32_t i = 0; i < n; i++) {
+            Napi::Value val = values.Get(i);
+            if (val.IsString()) {
+                node->lit_type = LIT_STR;
+                node->str_list.push_back(val.As<Napi::String>().Utf8Value());
+            } else if (val.IsBoolean()) {
+                node->num_list.push_back(val.As<Napi::Boolean>().Value() ? 1.0 : 0.0);
+            } else {
+                node->num_list.push_back(val.As<Napi::Number>().DoubleValue());
+            }
+        }
+        break;
+    }
+    case EXPR_NONE:
+        break;
     }
 
     return node;
@@ -64,18 +151,28 @@ std::vector<PlanStep> SerializePlan(Napi::Array ops) {
     for (uint32_t i = 0; i < len; i++) {
         Napi::Object op = ops.Get(i).As<Napi::Object>();
         PlanStep step;
-        step.type = op.Get("type").As<Napi::String>().Utf8Value();
+        step.type = (StepType)LookupName(kStepTypes, op.Get("type"));
 
-        if (step.type == "filter") {
+        if (step.type == STEP_FILTER) {
             step.filter_expr = SerializeExpr(op.Get("expr").As<Napi::Object>());
         }
-        else if (step.type == "group") {
-            // keys: string[]
+        else if (step.type == STEP_GROUP) {
+            // keys: string[] of result names; keyExprs: (Expr | null)[]
+            // when any key is computed
             Napi::Array keys = op.Get("keys").As<Napi::Array>();
             for (uint32_t k = 0; k < keys.Length(); k++) {
                 step.group_keys.push_back(
                     keys.Get(k).As<Napi::String>().Utf8Value());
             }
+            Napi::Value key_exprs = op.Get("keyExprs");
+            if (key_exprs.IsArray()) {
+                Napi::Array ke = key_exprs.As<Napi::Array>();
+                for (uint32_t k = 0; k < keys.Length(); k++) {
+                    Napi::Value e = ke.Get(k);
+                    step.group_key_exprs.push_back(
+                        e.IsObject() ? SerializeExpr(e.As<Napi::Object>()) : nullptr);
+                }
+            }
             // aggs: Expr[]
             Napi::Array aggs = op.Get("aggs").As<Napi::Array>();
             for (uint32_t a = 0; a < aggs.Length(); a++) {
@@ -83,7 +180,7 @@ std::vector<PlanStep> SerializePlan(Napi::Array ops) {
                     SerializeExpr(aggs.Get(a).As<Napi::Object>()));
             }
         }
-        else if (step.type == "sort") {
+        else if (step.type == STEP_SORT) {
             // cols: string[]
             Napi::Array cols = op.Get("cols").As<Napi::Array>();
             for (uint32_t c = 0; c < cols.Length(); c++) {
@@ -97,9 +194,17 @@ std::vector<PlanStep> SerializePlan(Napi::Array ops) {
                     descs.Get(d).As<Napi::Boolean>().Value());
             }
         }
-        else if (step.type == "head") {
+        else if (step.type == STEP_HEAD) {
             step.head_n = (int64_t)op.Get("n").As<Napi::Number>().Int64Value();
         }
+        else if (step.type == STEP_SELECT || step.type == STEP_WITH_COLUMNS) {
+            // exprs: Expr[]
+            Napi::Array exprs = op.Get("exprs").As<Napi::Array>();
+            for (uint32_t e = 0; e < exprs.Length(); e++) {
+                step.col_exprs.push_back(
+                    SerializeExpr(exprs.Get(e).As<Napi::Object>()));
+            }
+        }
 
         plan.push_back(std::move(step));
     }
@@ -114,10 +219,10 @@ std::vector<PlanStep> SerializePlan(Napi::Array ops) {
 td_op_t* EmitExpr(td_graph_t* g, const std::shared_ptr<ExprNode>& node) {
     if (!node) return nullptr;
 
-    if (node->kind == "col") {
+    switch (node->kind) {
+    case EXPR_COL:
         return td_scan(g, node->str_val.c_str());
-    }
-    else if (node->kind == "lit") {
+    case EXPR_LIT:
         switch (node->lit_type) {
             case LIT_BOOL:
                 return td_const_bool(g, node->bool_val);
@@ -133,46 +238,100 @@ td_op_t* EmitExpr(td_graph_t* g, const std::shared_ptr<ExprNode>& node) {
                 return td_const_f64(g, v);
             }
         }
-    }
-    else if (node->kind == "binop") {
+    case EXPR_BINOP: {
         td_op_t* left = EmitExpr(g, node->left);
         td_op_t* right = EmitExpr(g, node->right);
+        if (!left || !right) return nullptr;
 
-        const std::string& op = node->str_val;
-        if (op == "add") return td_add(g, left, right);
-        if (op == "sub") return td_sub(g, left, right);
-        if (op == "mul") return td_mul(g, left, right);
-        if (op == "div") return td_div(g, left, right);
-        if (op == "mod") return td_mod(g, left, right);
-        if (op == "eq")  return td_eq(g, left, right);
-        if (op == "ne")  return td_ne(g, left, right);
-        if (op == "lt")  return td_lt(g, left, right);
-        if (op == "le")  return td_le(g, left, right);
-        if (op == "gt")  return td_gt(g, left, right);
-        if (op == "ge")  return td_ge(g, left, right);
-        if (op == "and") return td_and(g, left, right);
-        if (op == "or")  return td_or(g, left, right);
-        return nullptr;
+        switch (node->opcode) {
+            case OP_ADD:   return td_add(g, left, right);
+            case OP_SUB:   return td_sub(g, left, right);
+            case OP_MUL:   return td_mul(g, left, right);
+            case OP_DIV:   return td_div(g, left, right);
+            case OP_MOD:   return td_mod(g, left, right);
+            case OP_EQ:    return td_eq(g, left, right);
+            case OP_NE:    return td_ne(g, left, right);
+            case OP_LT:    return td_lt(g, left, right);
+            case OP_LE:    return td_le(g, left, right);
+            case OP_GT:    return td_gt(g, left, right);
+            case OP_GE:    return td_ge(g, left, right);
+            case OP_AND:   return td_and(g, left, right);
+            case OP_OR:    return td_or(g, left, right);
+            case OP_MIN2:  return td_min2(g, left, right);
+            case OP_MAX2:  return td_max2(g, left, right);
+            case OP_LIKE:  return td_like(g, left, right);
+            case OP_ILIKE: return td_ilike(g, left, right);
+            default:       return nullptr;
+        }
     }
-    else if (node->kind == "unop") {
+    case EXPR_UNOP: {
         td_op_t* arg = EmitExpr(g, node->left);
+        if (!arg) return nullptr;
 
-        const std::string& op = node->str_val;
-        if (op == "neg")    return td_neg(g, arg);
-        if (op == "abs")    return td_abs(g, arg);
-        if (op == "not")    return td_not(g, arg);
-        if (op == "sqrt")   return td_sqrt_op(g, arg);
-        if (op == "log")    return td_log_op(g, arg);
-        if (op == "exp")    return td_exp_op(g, arg);
-        if (op == "ceil")   return td_ceil_op(g, arg);
-        if (op == "floor")  return td_floor_op(g, arg);
-        if (op == "isnull") return td_isnull(g, arg);
-        return nullptr;
+        switch (node->opcode) {
+            case OP_NEG:    return td_neg(g, arg);
+            case OP_ABS:    return td_abs(g, arg);
+            case OP_NOT:    return td_not(g, arg);
+            case OP_SQRT:   return td_sqrt_op(g, arg);
+            case OP_LOG:    return td_log_op(g, arg);
+            case OP_EXP:    return td_exp_op(g, arg);
+            case OP_CEIL:   return td_ceil_op(g, arg);
+            case OP_FLOOR:  return td_floor_op(g, arg);
+            case OP_ISNULL: return td_isnull(g, arg);
+            case OP_UPPER:  return td_upper(g, arg);
+            case OP_LOWER:  return td_lower(g, arg);
+            case OP_STRLEN: return td_strlen(g, arg);
+            case OP_TRIM:   return td_trim_op(g, arg);
+            default:        return nullptr;
+        }
+    }
+    case EXPR_CALL: {
+        // time_bucket's width and origin are numeric literals kept in the
+        // node, not operands
+        if (node->opcode == OP_TIME_BUCKET) {
+            const auto& a = node->args;
+            if (a.size() != 3 || !a[1] || !a[2] ||
+                a[1]->kind != EXPR_LIT || a[1]->lit_type != LIT_NUM ||
+                a[2]->kind != EXPR_LIT || a[2]->lit_type != LIT_NUM)
+                return nullptr;
+            td_op_t* arg = EmitExpr(g, a[0]);
+            if (!arg) return nullptr;
+            return td_time_bucket(g, arg, (int64_t)a[1]->num_val,
+                                  (int64_t)a[2]->num_val, (uint8_t)node->num_val);
+        }
+
+        std::vector<td_op_t*> args;
+        for (const auto& a : node->args) {
+            td_op_t* arg = EmitExpr(g, a);
+            if (!arg) return nullptr;
+            args.push_back(arg);
+        }
+
+        size_t n = args.size();
+        switch (node->opcode) {
+            case OP_IF:
+                return n == 3 ? td_if(g, args[0], args[1], args[2]) : nullptr;
+            case OP_SUBSTR:
+                return n == 3 ? td_substr(g, args[0], args[1], args[2]) : nullptr;
+            case OP_REPLACE:
+                return n == 3 ? td_replace(g, args[0], args[1], args[2]) : nullptr;
+            case OP_CONCAT:
+                return n >= 2 ? td_concat(g, args.data(), (int)n) : nullptr;
+            case OP_CAST:
+                return n == 1 ? td_cast(g, args[0], (int8_t)node->num_val) : nullptr;
+            case OP_EXTRACT:
+                return n == 1 ? td_extract(g, args[0], (int64_t)node->num_val) : nullptr;
+            case OP_DATE_TRUNC:
+                return n == 1 ? td_date_trunc(g, args[0], (int64_t)node->num_val) : nullptr;
+            default:
+                return nullptr;
+        }
     }
-    else if (node->kind == "agg") {
+    case EXPR_AGG: {
         td_op_t* arg = EmitExpr(g, node->left);
+        if (!arg) return nullptr;
 
-        switch (node->agg_opcode) {
+        switch (node->opcode) {
             case OP_SUM:   return td_sum(g, arg);
             case OP_PROD:  return td_prod(g, arg);
             case OP_MIN:   return td_min_op(g, arg);
@@ -181,39 +340,86 @@ td_op_t* EmitExpr(td_graph_t* g, const std::shared_ptr<ExprNode>& node) {
             case OP_AVG:   return td_avg(g, arg);
             case OP_FIRST: return td_first(g, arg);
             case OP_LAST:  return td_last(g, arg);
+            case OP_QUANTILE:
+            case OP_QUANTILE_APPROX:
+                return td_quantile(g, arg, node->num_val,
+                                   node->opcode == OP_QUANTILE_APPROX);
             default:       return nullptr;
         }
     }
-    else if (node->kind == "alias") {
+    case EXPR_ALIAS: {
         td_op_t* arg = EmitExpr(g, node->left);
+        if (!arg) return nullptr;
         return td_alias(g, arg, node->str_val.c_str());
     }
+    case EXPR_IN: {
+        td_op_t* arg = EmitExpr(g, node->left);
+        if (!arg) return nullptr;
+
+        // Strings resolve to symbol ids once here so the engine compares
+        // ids; a string that was never interned cannot match and is dropped.
+        td_t* set;
+        if (node->lit_type == LIT_STR) {
+            set = td_sym_vec_new(TD_SYM_W64, (int64_t)node->str_list.size());
+            if (!set || TD_IS_ERR(set)) return nullptr;
+            int64_t n = 0;
+            for (const auto& s : node->str_list) {
+                int64_t id = td_sym_find(s.c_str(), s.size());
+                if (id >= 0) ((int64_t*)td_data(set))[n++] = id;
+            }
+            set->len = n;
+        } else {
+            bool integral = true;
+            for (double v : node->num_list)
+                if (!(v == (double)(int64_t)v && v >= -9.22e18 && v <= 9.22e18))
+                    integral = false;
+            int64_t n = (int64_t)node->num_list.size();
+            set = td_vec_new(integral ? TD_I64 : TD_F64, n);
+            if (!set || TD_IS_ERR(set)) return nullptr;
+            for (int64_t i = 0; i < n; i++) {
+                if (integral) ((int64_t*)td_data(set))[i] = (int64_t)node->num_list[i];
+                else          ((double*)td_data(set))[i] = node->num_list[i];
+            }
+            set->len = n;
+        }
+        td_op_t* values = td_const_vec(g, set);
+        td_release(set);
+        if (!values) return nullptr;
+        return td_in(g, arg, values);
+    }
+    case EXPR_NONE:
+        break;
+    }
 
     return nullptr;
 }
 
 // ---------------------------------------------------------------------------
-// Decompose an agg Expr into (opcode, input_node) for td_group
+// Decompose an agg Expr into (opcode, input_node, param) for td_group
 // ---------------------------------------------------------------------------
 
 static void DecomposeAgg(td_graph_t* g,
                          const std::shared_ptr<ExprNode>& expr,
                          uint16_t& out_opcode,
                          td_op_t*& out_input,
+                         double& out_param,
                          td_op_t*& out_alias_node) {
     out_alias_node = nullptr;
+    out_param = 0.5;
 
     // Handle alias wrapping: alias(agg(...))
     const ExprNode* inner = expr.get();
     std::string alias_name;
-    if (inner->kind == "alias") {
+    if (inner->kind == EXPR_ALIAS) {
         alias_name = inner->str_val;
         inner = inner->left.get();
     }
 
-    if (inner->kind == "agg") {
-        out_opcode = (uint16_t)inner->agg_opcode;
+    if (inner->kind == EXPR_AGG) {
+        out_opcode = inner->opcode;
         out_input = EmitExpr(g, inner->left);
+        if (out_opcode == OP_QUANTILE || out_opcode == OP_QUANTILE_APPROX)
+            out_param = inner->num_val;
     } else {
         // Non-agg expression in agg list — treat as OP_FIRST
         out_opcode = OP_FIRST;
@@ -227,19 +433,31 @@ static void DecomposeAgg(td_graph_t* g,
 }
 
 // ---------------------------------------------------------------------------
-// ExecutePlan: walk serialized plan steps and emit graph nodes (Teide thread)
+// BuildPlan: walk serialized plan steps and emit graph nodes (Teide thread)
 // ---------------------------------------------------------------------------
 
-td_t* ExecutePlan(td_t* tbl, const std::vector<PlanStep>& plan) {
-    td_graph_t* g = td_graph_new(tbl);
-    if (!g) return TD_ERR_PTR(TD_ERR_OOM);
-
+// A filter that precedes a group step is not attached to the graph: its
+// predicate is evaluated on its own and handed to td_group as g->selection.
+// That predicate's node id is returned through *sel_id (UINT32_MAX if none);
+// an id rather than a pointer, since later nodes may realloc g->nodes.
+// Returns nullptr with *err set when a step can't be expressed as a graph:
+// an expression with no node (TD_ERR_NYI) or more than 255 output columns
+// (TD_ERR_RANGE).
+static td_op_t* BuildPlan(td_graph_t* g, td_t* tbl,
+                          const std::vector<PlanStep>& plan,
+                          uint32_t* sel_id, td_err_t* err) {
     td_op_t* current = nullptr;
     td_op_t* filter_pred = nullptr;
+    *sel_id = UINT32_MAX;
+    *err = TD_OK;
 
     for (const auto& step : plan) {
-        if (step.type == "filter") {
+        if (step.type == STEP_FILTER) {
             td_op_t* pred = EmitExpr(g, step.filter_expr);
+            if (!pred) {
+                *err = TD_ERR_NYI;
+                return nullptr;
+            }
             if (!current) {
                 // Accumulate predicates with AND
                 if (filter_pred) {
@@ -251,41 +469,43 @@ td_t* ExecutePlan(td_t* tbl, const std::vector<PlanStep>& plan) {
                 current = td_filter(g, current, pred);
             }
         }
-        else if (step.type == "group") {
-            // If there's a pending filter predicate, execute it and set selection
+        else if (step.type == STEP_GROUP) {
+            // A pending filter predicate becomes the group's selection
             if (filter_pred) {
-                td_t* mask = td_execute(g, filter_pred);
-                if (TD_IS_ERR(mask)) {
-                    td_graph_free(g);
-                    return mask;
-                }
-                td_retain(mask);
-                g->selection = mask;
+                *sel_id = filter_pred->id;
                 filter_pred = nullptr;
             }
 
-            // Emit key scan nodes
+            // Emit key nodes: column scans, or computed keys named by an alias
             uint8_t n_keys = (uint8_t)step.group_keys.size();
             std::vector<td_op_t*> key_nodes(n_keys);
             for (uint8_t k = 0; k < n_keys; k++) {
-                key_nodes[k] = td_scan(g, step.group_keys[k].c_str());
+                const char* name = step.group_keys[k].c_str();
+                td_op_t* key = k < step.group_key_exprs.size() && step.group_key_exprs[k]
+                    ? EmitExpr(g, step.group_key_exprs[k]) : nullptr;
+                key_nodes[k] = key ? td_alias(g, key, name) : td_scan(g, name);
             }
 
-            // Decompose agg_exprs into (opcode, input) pairs
+            // Decompose agg_exprs into (opcode, input, param) triples
             uint8_t n_aggs = (uint8_t)step.agg_exprs.size();
             std::vector<uint16_t> agg_ops(n_aggs);
             std::vector<td_op_t*> agg_ins(n_aggs);
+            std::vector<double> agg_params(n_aggs);
+            bool has_params = false;
             for (uint8_t a = 0; a < n_aggs; a++) {
                 td_op_t* alias_node = nullptr;
                 DecomposeAgg(g, step.agg_exprs[a],
-                           agg_ops[a], agg_ins[a], alias_node);
+                           agg_ops[a], agg_ins[a], agg_params[a], alias_node);
+                if (agg_ops[a] == OP_QUANTILE || agg_ops[a] == OP_QUANTILE_APPROX)
+                    has_params = true;
             }
 
-            current = td_group(g,
+            current = td_group_params(g,
                              key_nodes.data(), n_keys,
-                             agg_ops.data(), agg_ins.data(), n_aggs);
+                             agg_ops.data(), agg_ins.data(),
+                             has_params ? agg_params.data() : nullptr, n_aggs);
         }
-        else if (step.type == "sort") {
+        else if (step.type == STEP_SORT) {
             td_op_t* table_node = current ? current : td_const_table(g, tbl);
 
             // Apply pending filter
@@ -307,7 +527,36 @@ td_t* ExecutePlan(td_t* tbl, const std::vector<PlanStep>& plan) {
                                key_nodes.data(), descs.data(),
                                nullptr, n_cols);
         }
-        else if (step.type == "head") {
+        else if (step.type == STEP_SELECT || step.type == STEP_WITH_COLUMNS) {
+            td_op_t* table_node = current ? current : td_const_table(g, tbl);
+
+            // Apply pending filter
+            if (filter_pred) {
+                table_node = td_filter(g, table_node, filter_pred);
+                filter_pred = nullptr;
+            }
+
+            // Computed columns run as native kernels over the input table;
+            // the node counts its columns in a byte
+            if (step.col_exprs.size() > 255) {
+                *err = TD_ERR_RANGE;
+                return nullptr;
+            }
+            uint8_t n_cols = (uint8_t)step.col_exprs.size();
+            std::vector<td_op_t*> cols(n_cols);
+            for (uint8_t c = 0; c < n_cols; c++) {
+                cols[c] = EmitExpr(g, step.col_exprs[c]);
+                if (!cols[c]) {
+                    *err = TD_ERR_NYI;
+                    return nullptr;
+                }
+            }
+
+            current = step.type == STEP_SELECT
+                ? td_select(g, table_node, cols.data(), n_cols)
+                : td_with_columns(g, table_node, cols.data(), n_cols);
+        }
+        else if (step.type == STEP_HEAD) {
             if (!current) {
                 current = td_const_table(g, tbl);
             }
@@ -329,22 +578,546 @@ td_t* ExecutePlan(td_t* tbl, const std::vector<PlanStep>& plan) {
         current = td_filter(g, current, filter_pred);
     }
 
+    return current;
+}
+
+// ---------------------------------------------------------------------------
+// Plan snapshots for explain / profile (Teide thread)
+// ---------------------------------------------------------------------------
+
+static td_op_ext_t* FindExt(td_graph_t* g, uint32_t id) {
+    for (uint32_t i = 0; i < g->ext_count; i++) {
+        if (g->ext_nodes[i] && g->ext_nodes[i]->base.id == id)
+            return g->ext_nodes[i];
+    }
+    return nullptr;
+}
+
+static std::string SymName(int64_t sym) {
+    td_t* s = td_sym_str(sym);
+    if (!s) return "?";
+    return std::string(td_str_ptr(s), td_str_len(s));
+}
+
+static std::string LiteralText(td_t* v) {
+    if (!v || TD_IS_ERR(v)) return "null";
+    switch (v->type) {
+        case TD_ATOM_BOOL: return v->b8 ? "true" : "false";
+        case TD_ATOM_I64:  return std::to_string(v->i64);
+        case TD_ATOM_F64:  return std::to_string(v->f64);
+        case TD_ATOM_STR:
+            return "'" + std::string(td_str_ptr(v), td_str_len(v)) + "'";
+        case TD_TABLE:     return "table";
+        default:
+            if (v->type > 0) return "vector[" + std::to_string(v->len) + "]";
+            return "atom";
+    }
+}
+
+static int SnapshotNode(td_graph_t* g, td_op_t* op, PlanTree& tree,
+                        std::vector<int>& seen) {
+    if (!op) return -1;
+    if (op->id < seen.size() && seen[op->id] >= 0) return seen[op->id];
+
+    int idx = (int)tree.nodes.size();
+    tree.nodes.emplace_back();
+    if (op->id < seen.size()) seen[op->id] = idx;
+    {
+        PlanNode& n = tree.nodes[idx];
+        n.id = op->id;
+        n.op = td_op_name(op->opcode);
+        n.out_type = op->out_type;
+        n.est_rows = op->est_rows;
+        n.fused = (op->flags & OP_FLAG_FUSED) != 0;
+        n.shared = (op->flags & OP_FLAG_SHARED) != 0;
+        if (g->prof && op->id < g->prof_count && g->prof[op->id].calls) {
+            const td_op_prof_t& p = g->prof[op->id];
+            n.profiled = true;
+            n.calls = p.calls;
+            n.morsels = p.morsels;
+            n.dispatches = p.dispatches;
+            n.paths = p.flags;
+            n.ns = p.ns;
+            n.self_ns = p.self_ns;
+            n.rows_in = p.rows_in;
+            n.rows_out = p.rows_out;
+            n.mem_net = p.mem_net;
+            n.mem_peak = p.mem_peak;
+        }
+    }
+
+    // Children: regular inputs first, then operands kept in the ext node.
+    std::vector<td_op_t*> kids;
+    for (uint8_t i = 0; i < op->arity && i < 2; i++) kids.push_back(op->inputs[i]);
+
+    std::string detail;
+    td_op_ext_t* ext = FindExt(g, op->id);
+    if (ext) {
+        switch (op->opcode) {
+            case OP_SCAN:
+                detail = SymName(ext->sym);
+                break;
+            case OP_CONST:
+                detail = LiteralText(ext->literal);
+                break;
+            case OP_ALIAS:
+                detail = SymName(ext->sym);
+                break;
+            case OP_EXTRACT:
+            case OP_DATE_TRUNC: {
+                static const char* fields[] = {
+                    "year", "month", "day", "hour", "minute", "second", "dow", "doy", "epoch",
+                };
+                detail = ext->sym >= 0 && ext->sym < 9 ? fields[ext->sym] : "?";
+                break;
+            }
+            case OP_TIME_BUCKET: {
+                static const char* units[] = { "", "us", "mo" };
+                detail = "width=" + std::to_string(ext->bucket.width) +
+                         (ext->bucket.unit < 3 ? units[ext->bucket.unit] : "?");
+                if (ext->bucket.origin)
+                    detail += " origin=" + std::to_string(ext->bucket.origin);
+                break;
+            }
+            case OP_HEAD:
+            case OP_TAIL:
+                detail = "n=" + std::to_string(ext->sym);
+                break;
+            case OP_IF:
+            case OP_SUBSTR:
+            case OP_REPLACE: {
+                uint32_t third = (uint32_t)(uintptr_t)ext->literal;
+                if (third < g->node_count) kids.push_back(&g->nodes[third]);
+                break;
+            }
+            case OP_GROUP:
+                detail = "keys=" + std::to_string(ext->n_keys) +
+                         " aggs=";
+                for (uint8_t a = 0; a < ext->n_aggs; a++) {
+                    if (a) detail += ",";
+                    detail += td_op_name(ext->agg_ops[a]);
+                }
+                for (uint8_t k = 0; k < ext->n_keys; k++) kids.push_back(ext->keys[k]);
+                for (uint8_t a = 0; a < ext->n_aggs; a++) kids.push_back(ext->agg_ins[a]);
+                break;
+            case OP_SORT:
+                for (uint8_t c = 0; c < ext->sort.n_cols; c++) {
+                    if (c) detail += ",";
+                    detail += (ext->sort.desc && ext->sort.desc[c]) ? "desc" : "asc";
+                    kids.push_back(ext->sort.columns[c]);
+                }
+                break;
+            case OP_PROJECT:
+            case OP_SELECT:
+                if (op->opcode == OP_SELECT && ext->sort.keep_input)
+                    detail = "withColumns";
+                for (uint8_t c = 0; c < ext->sort.n_cols; c++)
+                    kids.push_back(ext->sort.columns[c]);
+                break;
+            case OP_JOIN:
+            case OP_WINDOW_JOIN: {
+                static const char* kinds[] = { "inner", "left", "full", "semi", "anti" };
+                uint8_t jt = ext->join.join_type;
+                detail = jt < 5 ? kinds[jt] : "?";
+                for (uint8_t k = 0; k < ext->join.n_join_keys; k++) {
+                    kids.push_back(ext->join.left_keys[k]);
+                    kids.push_back(ext->join.right_keys[k]);
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    std::vector<int> child_idx;
+    for (td_op_t* k : kids) {
+        int c = SnapshotNode(g, k, tree, seen);
+        if (c >= 0) child_idx.push_back(c);
+    }
+    // tree.nodes may have grown: index again rather than keep a reference.
+    tree.nodes[idx].detail = std::move(detail);
+    tree.nodes[idx].children = std::move(child_idx);
+    return idx;
+}
+
+static void SnapshotPlan(td_graph_t* g, td_op_t* root, uint32_t sel_id,
+                         PlanTree& tree) {
+    std::vector<int> seen(g->node_count, -1);
+    if (sel_id != UINT32_MAX && sel_id < g->node_count)
+        tree.selection = SnapshotNode(g, &g->nodes[sel_id], tree, seen);
+    tree.root = SnapshotNode(g, root, tree, seen);
+}
+
+// ---------------------------------------------------------------------------
+// ExecutePlan / ExplainPlan (Teide thread)
+// ---------------------------------------------------------------------------
+
+td_t* ExecutePlan(td_t* tbl, const std::vector<PlanStep>& plan,
+                  const CancelToken* cancel, PlanTree* profile) {
+    td_graph_t* g = td_graph_new(tbl);
+    if (!g) return TD_ERR_PTR(TD_ERR_OOM);
+
+    int64_t t0 = profile ? td_time_ns() : 0;
+    if (profile && td_graph_profile(g) != TD_OK) {
+        td_graph_free(g);
+        return TD_ERR_PTR(TD_ERR_OOM);
+    }
+
+    uint32_t sel_id;
+    td_err_t err;
+    td_op_t* current = BuildPlan(g, tbl, plan, &sel_id, &err);
+    if (!current) {
+        td_graph_free(g);
+        return TD_ERR_PTR(err != TD_OK ? err : TD_ERR_OOM);
+    }
+
+    // Evaluate a group's leading filter into a selection first
+    if (sel_id != UINT32_MAX) {
+        td_t* pred = td_execute(g, &g->nodes[sel_id]);
+        if (TD_IS_ERR(pred)) {
+            td_graph_free(g);
+            return pred;
+        }
+        // exec_group only honours a TD_SEL bitmap, not the raw BOOL vector
+        td_t* mask = td_sel_from_pred(pred);
+        td_release(pred);
+        if (!mask || TD_IS_ERR(mask)) {
+            td_graph_free(g);
+            return mask ? mask : TD_ERR_PTR(TD_ERR_OOM);
+        }
+        g->selection = mask;
+
+        // The next td_execute() resets the pool's cancel flag, so a
+        // cancel that landed between the two passes must be seen here.
+        if (cancel && cancel->expired()) {
+            td_graph_free(g);
+            return TD_ERR_PTR(TD_ERR_CANCEL);
+        }
+    }
+
     // Optimize and execute
     td_op_t* root = td_optimize(g, current);
     td_t* result = td_execute(g, root);
+    if (profile && !TD_IS_ERR(result)) {
+        profile->total_ns = td_time_ns() - t0;
+        SnapshotPlan(g, root, sel_id, *profile);
+    }
     td_graph_free(g);
     return result;
 }
 
+int ExplainPlan(td_t* tbl, const std::vector<PlanStep>& plan, PlanTree* out) {
+    td_graph_t* g = td_graph_new(tbl);
+    if (!g) return TD_ERR_OOM;
+
+    uint32_t sel_id;
+    td_err_t err;
+    td_op_t* current = BuildPlan(g, tbl, plan, &sel_id, &err);
+    if (!current) {
+        td_graph_free(g);
+        return err != TD_OK ? err : TD_ERR_OOM;
+    }
+    td_op_t* root = td_optimize(g, current);
+    SnapshotPlan(g, root, sel_id, *out);
+    td_graph_free(g);
+    return TD_OK;
+}
+
+// ---------------------------------------------------------------------------
+// ExecutePlans: several plans over one table in one graph (Teide thread)
+// ---------------------------------------------------------------------------
+
+// One plan's share of a batch: the unit (a root of the shared graph) it
+// reads, the plan steps still to run on that unit's result, and for plans
+// that start with a group-by, where each of its aggregates landed among
+// the unit's.
+struct BatchMember {
+    size_t unit = 0;
+    size_t tail = 0;
+    std::vector<int> agg_map;
+};
+
+// The agg input DecomposeAgg emits is a plain column scan, so the result
+// column is named after that column rather than by position.
+static bool AggReadsColumn(const std::shared_ptr<ExprNode>& expr) {
+    const ExprNode* inner = expr->kind == EXPR_ALIAS ? expr->left.get() : expr.get();
+    const ExprNode* in = inner->kind == EXPR_AGG ? inner->left.get()
+                       : expr->left ? expr->left.get() : expr.get();
+    return in && in->kind == EXPR_COL;
+}
+
+// "_e7_sum" -> "_e<pos>_sum"
+static int64_t RenumberExprAgg(int64_t name, size_t pos) {
+    td_t* atom = td_sym_str(name);
+    if (!atom) return name;
+    std::string s(td_str_ptr(atom), td_str_len(atom));
+    size_t end = 2;
+    while (end < s.size() && s[end] >= '0' && s[end] <= '9') end++;
+    if (s.compare(0, 2, "_e") != 0 || end == 2) return name;
+    s = "_e" + std::to_string(pos) + s.substr(end);
+    return td_sym_intern(s.c_str(), s.size());
+}
+
+// The key columns and `m`'s aggregates of a shared group-by result, in the
+// order the plan's own group step would have produced them.
+static td_t* ProjectGroup(td_t* res, const PlanStep& step, const BatchMember& m) {
+    int64_t n_keys = (int64_t)step.group_keys.size();
+    bool identity = td_table_ncols(res) == n_keys + (int64_t)m.agg_map.size();
+    for (size_t a = 0; identity && a < m.agg_map.size(); a++)
+        identity = m.agg_map[a] == (int)a;
+    if (identity) {
+        td_retain(res);
+        return res;
+    }
+
+    td_t* out = td_table_new(n_keys + (int64_t)m.agg_map.size());
+    for (int64_t c = 0; c < n_keys && out && !TD_IS_ERR(out); c++)
+        out = td_table_add_col(out, td_table_col_name(res, c), td_table_get_col_idx(res, c));
+    for (size_t a = 0; a < m.agg_map.size() && out && !TD_IS_ERR(out); a++) {
+        int64_t src = n_keys + m.agg_map[a];
+        int64_t name = td_table_col_name(res, src);
+        if (!AggReadsColumn(step.agg_exprs[a])) name = RenumberExprAgg(name, a);
+        out = td_table_add_col(out, name, td_table_get_col_idx(res, src));
+    }
+    return out ? out : TD_ERR_PTR(TD_ERR_OOM);
+}
+
+// Aggregates one td_group can evaluate: exec_group fails with TD_ERR_NYI
+// above this, so a shared unit that would outgrow it starts a new one.
+static constexpr size_t kMaxGroupAggs = 8;
+
+std::vector<td_t*> ExecutePlans(td_t* tbl, const std::vector<std::vector<PlanStep>>& plans,
+                                const CancelToken* cancel) {
+    // Split each plan into a unit of the shared graph and a tail run on the
+    // unit's result. Plans that open with the same filters and group keys
+    // share one group-by unit holding the union of their aggregates.
+    std::vector<std::vector<PlanStep>> units;
+    std::vector<std::vector<std::string>> unit_aggs;   // ExprKey per unit aggregate
+    std::vector<size_t> unit_uses;
+    std::vector<BatchMember> members(plans.size());
+    std::unordered_map<std::string, size_t> open_groups;
+
+    for (size_t q = 0; q < plans.size(); q++) {
+        const auto& plan = plans[q];
+        BatchMember& m = members[q];
+        size_t k = 0;
+        while (k < plan.size() && plan[k].type == STEP_FILTER) k++;
+        if (k == plan.size() || plan[k].type != STEP_GROUP) {
+            m.unit = units.size();
+            m.tail = plan.size();
+            units.push_back(plan);
+            unit_aggs.emplace_back();
+            unit_uses.push_back(1);
+            continue;
+        }
+
+        const PlanStep& grp = plan[k];
+        std::vector<std::string> agg_keys;
+        for (const auto& a : grp.agg_exprs) agg_keys.push_back(ResultCache::ExprKey(a.get()));
+
+        // Filters commute, so the class key orders them like the cache key
+        std::vector<PlanStep> cls(plan.begin(), plan.begin() + k);
+        cls.emplace_back();
+        cls.back().type = STEP_GROUP;
+        cls.back().group_keys = grp.group_keys;
+        cls.back().group_key_exprs = grp.group_key_exprs;
+        std::string cls_key = ResultCache::Key(0, 0, cls);
+
+        size_t u = SIZE_MAX;
+        auto it = open_groups.find(cls_key);
+        if (it != open_groups.end()) {
+            const auto& have = unit_aggs[it->second];
+            size_t added = 0;
+            for (const auto& key : agg_keys)
+                if (std::find(have.begin(), have.end(), key) == have.end()) added++;
+            if (have.size() + added <= kMaxGroupAggs) u = it->second;
+        }
+        if (u == SIZE_MAX) {
+            u = units.size();
+            units.emplace_back(plan.begin(), plan.begin() + k + 1);
+            units.back().back().agg_exprs.clear();
+            unit_aggs.emplace_back();
+            unit_uses.push_back(0);
+            open_groups[cls_key] = u;
+        }
+        m.unit = u;
+        m.tail = k + 1;
+        unit_uses[u]++;
+        auto& have = unit_aggs[u];
+        for (size_t a = 0; a < agg_keys.size(); a++) {
+            auto f = std::find(have.begin(), have.end(), agg_keys[a]);
+            if (f == have.end()) {
+                have.push_back(agg_keys[a]);
+                units[u].back().agg_exprs.push_back(grp.agg_exprs[a]);
+                f = have.end() - 1;
+            }
+            m.agg_map.push_back((int)(f - have.begin()));
+        }
+    }
+
+    std::vector<td_t*> results(plans.size(), nullptr);
+    size_t n_units = units.size();
+    std::vector<td_t*> outs(n_units, nullptr);
+
+    td_graph_t* g = td_graph_new(tbl);
+    td_err_t err = g ? TD_OK : TD_ERR_OOM;
+    if (g) {
+        // Node ids, not pointers: later units may realloc g->nodes
+        std::vector<uint32_t> root_ids(n_units), sel_ids(n_units);
+        for (size_t u = 0; u < n_units && err == TD_OK; u++) {
+            td_op_t* root = BuildPlan(g, tbl, units[u], &sel_ids[u], &err);
+            if (!root) err = err != TD_OK ? err : TD_ERR_OOM;
+            else root_ids[u] = root->id;
+        }
+
+        if (err == TD_OK) {
+            // Selection predicates are optimized with the roots, so a filter
+            // shared with another plan is matched by CSE and kept by DCE.
+            std::vector<td_op_t*> nodes;
+            for (size_t u = 0; u < n_units; u++) nodes.push_back(&g->nodes[root_ids[u]]);
+            for (size_t u = 0; u < n_units; u++)
+                if (sel_ids[u] != UINT32_MAX) nodes.push_back(&g->nodes[sel_ids[u]]);
+            td_optimize_many(g, nodes.data(), (uint32_t)nodes.size());
+
+            std::vector<td_op_t*> preds(n_units, nullptr);
+            for (size_t u = 0, p = n_units; u < n_units; u++)
+                if (sel_ids[u] != UINT32_MAX) preds[u] = nodes[p++];
+            if (cancel && cancel->expired()) err = TD_ERR_CANCEL;
+            else err = td_execute_many(g, nodes.data(), preds.data(),
+                                       (uint32_t)n_units, outs.data());
+        }
+        td_graph_free(g);
+    }
+    if (err != TD_OK) {
+        for (td_t*& o : outs) {
+            if (o && !TD_IS_ERR(o)) td_release(o);
+            o = TD_ERR_PTR(err);
+        }
+    }
+
+    for (size_t q = 0; q < plans.size(); q++) {
+        const auto& plan = plans[q];
+        const BatchMember& m = members[q];
+        td_t* out = outs[m.unit];
+        if (TD_IS_ERR(out)) {
+            // A failure in another plan's aggregate must not fail this one
+            bool shared = unit_uses[m.unit] > 1 && TD_ERR_CODE(out) != TD_ERR_CANCEL;
+            results[q] = shared ? ExecutePlan(tbl, plan, cancel) : out;
+            continue;
+        }
+        td_t* res = m.agg_map.empty() && m.tail == plan.size()
+            ? (td_retain(out), out)
+            : ProjectGroup(out, plan[m.tail - 1], m);
+        if (m.tail < plan.size() && !TD_IS_ERR(res)) {
+            std::vector<PlanStep> tail(plan.begin() + m.tail, plan.end());
+            td_t* next = cancel && cancel->expired() ? TD_ERR_PTR(TD_ERR_CANCEL)
+                                                     : ExecutePlan(res, tail, cancel);
+            td_release(res);
+            res = next;
+        }
+        results[q] = res;
+    }
+    for (td_t* o : outs)
+        if (!TD_IS_ERR(o)) td_release(o);
+    return results;
+}
+
+// ---------------------------------------------------------------------------
+// PlanTreeToJS: nested plain objects (V8 thread)
+// ---------------------------------------------------------------------------
+
+static Napi::Object PlanNodeToJS(Napi::Env env, const PlanTree& tree, int idx) {
+    const PlanNode& n = tree.nodes[idx];
+    Napi::Object o = Napi::Object::New(env);
+    o.Set("id", Napi::Number::New(env, n.id));
+    o.Set("op", Napi::String::New(env, n.op));
+    if (!n.detail.empty()) o.Set("detail", Napi::String::New(env, n.detail));
+    o.Set("outType", Napi::Number::New(env, n.out_type));
+    o.Set("estRows", Napi::Number::New(env, n.est_rows));
+    o.Set("fused", Napi::Boolean::New(env, n.fused));
+    o.Set("shared", Napi::Boolean::New(env, n.shared));
+
+    if (n.profiled) {
+        Napi::Array paths = Napi::Array::New(env);
+        uint32_t np = 0;
+        if (n.paths & TD_PROF_PARALLEL) paths.Set(np++, Napi::String::New(env, "parallel"));
+        if (n.paths & TD_PROF_RADIX)    paths.Set(np++, Napi::String::New(env, "radix"));
+        if (n.paths & TD_PROF_DA)       paths.Set(np++, Napi::String::New(env, "direct-array"));
+        if (n.paths & TD_PROF_TOPN)     paths.Set(np++, Napi::String::New(env, "top-n"));
+        if (n.paths & TD_PROF_SEL)      paths.Set(np++, Napi::String::New(env, "lazy-selection"));
+        if (n.paths & TD_PROF_MERGE)    paths.Set(np++, Napi::String::New(env, "merge"));
+        if (n.paths & TD_PROF_LATE)     paths.Set(np++, Napi::String::New(env, "late-materialization"));
+        if (n.paths & TD_PROF_PARTED)   paths.Set(np++, Napi::String::New(env, "partition-wise"));
+
+        o.Set("calls", Napi::Number::New(env, n.calls));
+        o.Set("timeMs", Napi::Number::New(env, (double)n.ns / 1e6));
+        o.Set("selfTimeMs", Napi::Number::New(env, (double)n.self_ns / 1e6));
+        o.Set("rowsIn", Napi::Number::New(env, (double)n.rows_in));
+        o.Set("rowsOut", Napi::Number::New(env, (double)n.rows_out));
+        o.Set("memNetBytes", Napi::Number::New(env, (double)n.mem_net));
+        o.Set("memPeakBytes", Napi::Number::New(env, (double)n.mem_peak));
+        o.Set("morsels", Napi::Number::New(env, n.morsels));
+        o.Set("dispatches", Napi::Number::New(env, n.dispatches));
+        o.Set("paths", paths);
+    }
+
+    Napi::Array children = Napi::Array::New(env, n.children.size());
+    for (size_t i = 0; i < n.children.size(); i++)
+        children.Set((uint32_t)i, PlanNodeToJS(env, tree, n.children[i]));
+    o.Set("children", children);
+    return o;
+}
+
+Napi::Value PlanTreeToJS(Napi::Env env, const PlanTree& tree) {
+    Napi::Object o = Napi::Object::New(env);
+    if (tree.root >= 0) o.Set("root", PlanNodeToJS(env, tree, tree.root));
+    if (tree.selection >= 0)
+        o.Set("selection", PlanNodeToJS(env, tree, tree.selection));
+    if (tree.total_ns > 0)
+        o.Set("totalMs", Napi::Number::New(env, (double)tree.total_ns / 1e6));
+    return o;
+}
+
 // ---------------------------------------------------------------------------
 // QueryCollectSync: synchronous query execution exposed to JS
 // ---------------------------------------------------------------------------
 
+// `{ profile: true }` in the collect options requests EXPLAIN ANALYZE data.
+static std::shared_ptr<PlanTree> ProfileFromOpts(Napi::Value opts) {
+    if (!opts.IsObject()) return nullptr;
+    Napi::Value p = opts.As<Napi::Object>().Get("profile");
+    if (!p.IsBoolean() || !p.As<Napi::Boolean>().Value()) return nullptr;
+    return std::make_shared<PlanTree>();
+}
+
+// Result cache key for this collect, or "" when the cache is not consulted:
+// none configured, `{ cache: false }`, or a profile was requested (a cached
+// hit would have nothing to profile).
+static std::string CacheKeyFor(NativeTable* table, const std::vector<PlanStep>& plan,
+                               Napi::Value opts, bool profile) {
+    if (profile || !table->thread()->result_cache() || !table->cacheable()) return "";
+    if (opts.IsObject()) {
+        Napi::Value c = opts.As<Napi::Object>().Get("cache");
+        if (c.IsBoolean() && !c.As<Napi::Boolean>().Value()) return "";
+    }
+    return ResultCache::Key(table->id(), table->version(), plan);
+}
+
+// `cached`: res went through the result cache (a hit, or stored after
+// running) and may be shared with other callers.
+static Napi::Object WrapResult(Napi::Env env, td_t* res, TeideThread* thread,
+                               const std::shared_ptr<PlanTree>& profile, bool cached) {
+    Napi::Object obj = NativeTable::Create(env, res, thread, cached);
+    if (profile) obj.Set("profile", PlanTreeToJS(env, *profile));
+    return obj;
+}
+
 Napi::Value QueryCollectSync(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
 
     if (info.Length() < 2) {
-        Napi::TypeError::New(env, "collectSync requires (NativeTable, ops[])")
+        Napi::TypeError::New(env, "collectSync requires (NativeTable, ops[], opts?)")
             .ThrowAsJavaScriptException();
         return env.Undefined();
     }
@@ -358,12 +1131,24 @@ Napi::Value QueryCollectSync(const Napi::CallbackInfo& info) {
     // Serialize the plan on the main (V8) thread
     Napi::Array ops = info[1].As<Napi::Array>();
     std::vector<PlanStep> plan = SerializePlan(ops);
+    auto token = CancelTokenFromOpts(info[2]);
+    auto profile = ProfileFromOpts(info[2]);
 
-    // Dispatch to Teide thread
+    ResultCache* cache = thread->result_cache();
+    std::string key = CacheKeyFor(table, plan, info[2], profile != nullptr);
+    if (!key.empty()) {
+        if (td_t* hit = cache->Get(key)) return WrapResult(env, hit, thread, nullptr, true);
+    }
+    uint64_t table_id = table->id();
+
+    // Dispatch to Teide thread. The call blocks until the work has run, so
+    // the plan is borrowed rather than copied into the closure.
     void* result = thread->dispatch_sync(
-        [tbl_ptr, plan]() -> void* {
-            return (void*)ExecutePlan(tbl_ptr, plan);
-        });
+        [tbl_ptr, &plan, &token, &profile, cache, &key, table_id]() -> void* {
+            td_t* res = ExecutePlan(tbl_ptr, plan, token.get(), profile.get());
+            if (!key.empty()) cache->Put(key, table_id, res);
+            return (void*)res;
+        }, token);
 
     td_t* res = (td_t*)result;
     if (TD_IS_ERR(res)) {
@@ -373,7 +1158,7 @@ Napi::Value QueryCollectSync(const Napi::CallbackInfo& info) {
         return env.Undefined();
     }
 
-    return NativeTable::Create(env, res, thread);
+    return WrapResult(env, res, thread, profile, !key.empty());
 }
 
 // ---------------------------------------------------------------------------
@@ -384,7 +1169,7 @@ Napi::Value QueryCollect(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
 
     if (info.Length() < 2) {
-        Napi::TypeError::New(env, "collect requires (NativeTable, ops[])")
+        Napi::TypeError::New(env, "collect requires (NativeTable, ops[], opts?)")
             .ThrowAsJavaScriptException();
         return env.Undefined();
     }
@@ -395,34 +1180,263 @@ Napi::Value QueryCollect(const Napi::CallbackInfo& info) {
     td_t* tbl_ptr = table->ptr();
     TeideThread* thread = table->thread();
 
-    // Retain the source table so it stays alive during async execution
-    td_retain(tbl_ptr);
-
     // Serialize the plan on the main (V8) thread
     Napi::Array ops = info[1].As<Napi::Array>();
     std::vector<PlanStep> plan = SerializePlan(ops);
+    auto token = CancelTokenFromOpts(info[2]);
+    auto profile = ProfileFromOpts(info[2]);
 
     auto deferred = Napi::Promise::Deferred::New(env);
+
+    ResultCache* cache = thread->result_cache();
+    std::string key = CacheKeyFor(table, plan, info[2], profile != nullptr);
+    if (!key.empty()) {
+        if (td_t* hit = cache->Get(key)) {
+            deferred.Resolve(WrapResult(env, hit, thread, nullptr, true));
+            return deferred.Promise();
+        }
+    }
+    uint64_t table_id = table->id();
+
+    // Retain the source table so it stays alive during async execution
+    td_retain(tbl_ptr);
+
     auto tsfn = Napi::ThreadSafeFunction::New(env, Napi::Function(),
                                                "collect", 0, 1);
 
     thread->dispatch_async(
-        [tbl_ptr, plan]() -> void* {
-            void* result = (void*)ExecutePlan(tbl_ptr, plan);
+        [tbl_ptr, plan, token, profile, cache, key, table_id]() -> void* {
+            td_t* res = ExecutePlan(tbl_ptr, plan, token.get(), profile.get());
+            if (!key.empty()) cache->Put(key, table_id, res);
             td_release(tbl_ptr);
-            return result;
+            return (void*)res;
         },
         tsfn,
-        [deferred, thread](Napi::Env env, void* data) {
+        [deferred, thread, profile, cached = !key.empty()](Napi::Env env, void* data) {
             td_t* res = (td_t*)data;
             if (TD_IS_ERR(res)) {
                 deferred.Reject(Napi::Error::New(env,
                     std::string("Query execution failed: ") +
                     td_err_str(TD_ERR_CODE(res))).Value());
             } else {
-                deferred.Resolve(NativeTable::Create(env, res, thread));
+                deferred.Resolve(WrapResult(env, res, thread, profile, cached));
+            }
+        },
+        token,
+        // Skipped before it ran: drop the retain taken above.
+        [tbl_ptr]() { td_release(tbl_ptr); }
+    );
+
+    return deferred.Promise();
+}
+
+// ---------------------------------------------------------------------------
+// QueryExplain: optimized plan without execution (synchronous)
+// ---------------------------------------------------------------------------
+
+Napi::Value QueryExplain(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2) {
+        Napi::TypeError::New(env, "explain requires (NativeTable, ops[])")
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    NativeTable* table = Napi::ObjectWrap<NativeTable>::Unwrap(
+        info[0].As<Napi::Object>());
+    td_t* tbl_ptr = table->ptr();
+    TeideThread* thread = table->thread();
+
+    Napi::Array ops = info[1].As<Napi::Array>();
+    std::vector<PlanStep> plan = SerializePlan(ops);
+
+    PlanTree tree;
+    void* res = thread->dispatch_sync([tbl_ptr, &plan, &tree]() -> void* {
+        return (void*)(uintptr_t)ExplainPlan(tbl_ptr, plan, &tree);
+    });
+    td_err_t err = (td_err_t)(uintptr_t)res;
+    if (err != TD_OK) {
+        Napi::Error::New(env, std::string("explain failed: ") + td_err_str(err))
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    return PlanTreeToJS(env, tree);
+}
+
+// ---------------------------------------------------------------------------
+// QueryCollectMany: several queries in one dispatch, run as shared batches
+// ---------------------------------------------------------------------------
+
+// The queries of one collectMany call (serialized on the V8 thread).
+struct QueryBatch {
+    std::vector<td_t*> tables;               // per query: source table
+    std::vector<std::vector<PlanStep>> plans;
+    std::vector<std::string> keys;           // per query: result cache key, or ""
+    std::vector<uint64_t> table_ids;
+};
+
+// Unpacks `(NativeTable[], ops[][], opts?)`; throws and returns nullptr on
+// bad arguments. Every query must come from the same context.
+static std::shared_ptr<QueryBatch> BatchFromArgs(const Napi::CallbackInfo& info,
+                                                 const char* name,
+                                                 TeideThread** thread) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 2 || !info[0].IsArray() || !info[1].IsArray() ||
+        info[0].As<Napi::Array>().Length() != info[1].As<Napi::Array>().Length()) {
+        Napi::TypeError::New(env, std::string(name) + " requires (NativeTable[], ops[][], opts?)")
+            .ThrowAsJavaScriptException();
+        return nullptr;
+    }
+    Napi::Array tables = info[0].As<Napi::Array>();
+    Napi::Array ops = info[1].As<Napi::Array>();
+
+    auto batch = std::make_shared<QueryBatch>();
+    *thread = nullptr;
+    for (uint32_t i = 0; i < tables.Length(); i++) {
+        NativeTable* table = Napi::ObjectWrap<NativeTable>::Unwrap(
+            tables.Get(i).As<Napi::Object>());
+        if (*thread && table->thread() != *thread) {
+            Napi::TypeError::New(env, std::string(name) + ": queries must share one context")
+                .ThrowAsJavaScriptException();
+            return nullptr;
+        }
+        *thread = table->thread();
+        batch->plans.push_back(SerializePlan(ops.Get(i).As<Napi::Array>()));
+        batch->tables.push_back(table->ptr());
+        batch->keys.push_back(CacheKeyFor(table, batch->plans.back(), info[2], false));
+        batch->table_ids.push_back(table->id());
+    }
+    return batch;
+}
+
+// Teide thread. Queries over the same table run as one ExecutePlans batch;
+// cached results are taken as they are. Returns a TD_LIST of the results in
+// query order, or the first query's error.
+static td_t* RunBatch(const QueryBatch& b, ResultCache* cache, const CancelToken* cancel) {
+    size_t n = b.plans.size();
+    std::vector<td_t*> res(n, nullptr);
+    std::vector<td_t*> sources;
+    std::vector<std::vector<size_t>> slots;
+    for (size_t i = 0; i < n; i++) {
+        if (!b.keys[i].empty() && (res[i] = cache->Get(b.keys[i]))) continue;
+        size_t s = std::find(sources.begin(), sources.end(), b.tables[i]) - sources.begin();
+        if (s == sources.size()) {
+            sources.push_back(b.tables[i]);
+            slots.emplace_back();
+        }
+        slots[s].push_back(i);
+    }
+    for (size_t s = 0; s < sources.size(); s++) {
+        std::vector<std::vector<PlanStep>> plans;
+        for (size_t i : slots[s]) plans.push_back(b.plans[i]);
+        std::vector<td_t*> out = ExecutePlans(sources[s], plans, cancel);
+        for (size_t j = 0; j < out.size(); j++) {
+            size_t i = slots[s][j];
+            res[i] = out[j];
+            if (!b.keys[i].empty()) cache->Put(b.keys[i], b.table_ids[i], out[j]);
+        }
+    }
+
+    td_t* err = nullptr;
+    for (td_t* r : res)
+        if (TD_IS_ERR(r)) { err = r; break; }
+    td_t* list = err ? nullptr : td_list_new((int64_t)n);
+    if (!err && (!list || TD_IS_ERR(list))) err = list ? list : TD_ERR_PTR(TD_ERR_OOM);
+    for (td_t* r : res) {
+        if (TD_IS_ERR(r)) continue;
+        if (!err) {
+            td_t* grown = td_list_append(list, r);
+            if (!grown || TD_IS_ERR(grown)) {
+                td_release(list);
+                err = grown ? grown : TD_ERR_PTR(TD_ERR_OOM);
+            } else {
+                list = grown;
             }
         }
+        td_release(r);
+    }
+    return err ? err : list;
+}
+
+static Napi::Array WrapResults(Napi::Env env, td_t* list, const QueryBatch& b,
+                               TeideThread* thread) {
+    Napi::Array arr = Napi::Array::New(env, (size_t)list->len);
+    for (int64_t i = 0; i < list->len; i++) {
+        td_t* t = td_list_get(list, i);
+        td_retain(t);
+        arr.Set((uint32_t)i, NativeTable::Create(env, t, thread, !b.keys[i].empty()));
+    }
+    td_release(list);
+    return arr;
+}
+
+Napi::Value QueryCollectManySync(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    TeideThread* thread;
+    auto batch = BatchFromArgs(info, "collectManySync", &thread);
+    if (!batch) return env.Undefined();
+    if (!thread) return Napi::Array::New(env);
+
+    auto token = CancelTokenFromOpts(info[2]);
+    ResultCache* cache = thread->result_cache();
+    td_t* res = (td_t*)thread->dispatch_sync(
+        [batch, cache, token]() -> void* {
+            return RunBatch(*batch, cache, token.get());
+        }, token);
+
+    if (TD_IS_ERR(res)) {
+        std::string msg = "Query execution failed: ";
+        msg += td_err_str(TD_ERR_CODE(res));
+        Napi::Error::New(env, msg).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    return WrapResults(env, res, *batch, thread);
+}
+
+Napi::Value QueryCollectMany(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    TeideThread* thread;
+    auto batch = BatchFromArgs(info, "collectMany", &thread);
+    if (!batch) return env.Undefined();
+
+    auto deferred = Napi::Promise::Deferred::New(env);
+    if (!thread) {
+        deferred.Resolve(Napi::Array::New(env));
+        return deferred.Promise();
+    }
+    auto token = CancelTokenFromOpts(info[2]);
+    ResultCache* cache = thread->result_cache();
+
+    // Retain the source tables so they stay alive during async execution
+    for (td_t* t : batch->tables) td_retain(t);
+    auto release = [batch]() {
+        for (td_t* t : batch->tables) td_release(t);
+    };
+
+    auto tsfn = Napi::ThreadSafeFunction::New(env, Napi::Function(),
+                                               "collectMany", 0, 1);
+
+    thread->dispatch_async(
+        [batch, cache, token, release]() -> void* {
+            td_t* res = RunBatch(*batch, cache, token.get());
+            release();
+            return (void*)res;
+        },
+        tsfn,
+        [deferred, batch, thread](Napi::Env env, void* data) {
+            td_t* res = (td_t*)data;
+            if (TD_IS_ERR(res)) {
+                deferred.Reject(Napi::Error::New(env,
+                    std::string("Query execution failed: ") +
+                    td_err_str(TD_ERR_CODE(res))).Value());
+            } else {
+                deferred.Resolve(WrapResults(env, res, *batch, thread));
+            }
+        },
+        token,
+        // Skipped before it ran: drop the retains taken above.
+        release
     );
 
     return deferred.Promise();
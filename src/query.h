@@ -19,32 +19,86 @@ class TeideThread;
 // Literal type discriminator for ExprNode
 enum LitType { LIT_NUM = 0, LIT_BOOL = 1, LIT_STR = 2 };
 
+// Expr.kind of lib/expr.ts, resolved once on the V8 thread
+enum ExprKind : uint8_t {
+    EXPR_NONE = 0, EXPR_COL, EXPR_LIT, EXPR_BINOP, EXPR_UNOP,
+    EXPR_AGG, EXPR_ALIAS, EXPR_IN, EXPR_CALL,
+};
+
 // Serialized expression node (safe to pass across threads)
 struct ExprNode {
-    std::string kind;      // "col", "lit", "binop", "unop", "agg", "alias"
-    std::string str_val;   // col name, op name, alias name, string literal
-    double num_val = 0;
+    ExprKind kind = EXPR_NONE;
+    std::string str_val;   // col name, alias name, string literal
+    double num_val = 0;    // numeric literal, call option (cast type, date field, bucket unit), quantile fraction
     bool bool_val = false;
-    int agg_opcode = 0;
-    LitType lit_type = LIT_NUM;
-    std::shared_ptr<ExprNode> left;   // binop left, unop/agg/alias arg
+    // Engine opcode (OP_* in td.h) of a binop, unop, call or agg; 0 for an
+    // operator name the engine does not know.
+    uint16_t opcode = 0;
+    LitType lit_type = LIT_NUM;       // lit value, or "in" list element type
+    std::vector<double> num_list;     // "in" numeric/boolean values
+    std::vector<std::string> str_list; // "in" string values
+    std::shared_ptr<ExprNode> left;   // binop left, unop/agg/alias/in arg
     std::shared_ptr<ExprNode> right;  // binop right
+    std::vector<std::shared_ptr<ExprNode>> args; // "call" arguments
+};
+
+enum StepType : uint8_t {
+    STEP_NONE = 0, STEP_FILTER, STEP_GROUP, STEP_SORT, STEP_HEAD,
+    STEP_SELECT, STEP_WITH_COLUMNS,
 };
 
 // Serialized plan step (safe to pass across threads)
 struct PlanStep {
-    std::string type;
+    StepType type = STEP_NONE;
     std::shared_ptr<ExprNode> filter_expr;           // for 'filter'
-    std::vector<std::string> group_keys;             // for 'group'
+    std::vector<std::string> group_keys;             // for 'group': key column names
+    std::vector<std::shared_ptr<ExprNode>> group_key_exprs; // computed keys, null for a column; empty if none
     std::vector<std::shared_ptr<ExprNode>> agg_exprs; // for 'group'
     std::vector<std::string> sort_cols;               // for 'sort'
     std::vector<bool> sort_descs;                     // for 'sort'
     int64_t head_n = 0;                               // for 'head'
+    std::vector<std::shared_ptr<ExprNode>> col_exprs; // for 'select' / 'withColumns'
+};
+
+// Snapshot of one optimized-plan node, plus its execution profile when one
+// was collected. Copied out of the graph on the Teide thread so it can be
+// turned into JS objects after the graph is freed.
+struct PlanNode {
+    uint32_t id = 0;
+    std::string op;                 // td_op_name()
+    std::string detail;             // column, literal, limit, ...
+    int out_type = 0;
+    uint32_t est_rows = 0;
+    bool fused = false;
+    bool shared = false;
+    std::vector<int> children;      // indices into PlanTree::nodes
+
+    bool profiled = false;          // true once exec_node ran the node
+    uint32_t calls = 0;
+    uint32_t morsels = 0;
+    uint32_t dispatches = 0;
+    uint8_t paths = 0;              // TD_PROF_* flags
+    int64_t ns = 0;
+    int64_t self_ns = 0;
+    int64_t rows_in = 0;
+    int64_t rows_out = 0;
+    int64_t mem_net = 0;
+    int64_t mem_peak = 0;
+};
+
+struct PlanTree {
+    std::vector<PlanNode> nodes;
+    int root = -1;
+    int selection = -1;             // filter evaluated up front into g->selection
+    int64_t total_ns = 0;
 };
 
 // Static query execution functions exposed to JS
 Napi::Value QueryCollectSync(const Napi::CallbackInfo& info);
 Napi::Value QueryCollect(const Napi::CallbackInfo& info);
+Napi::Value QueryExplain(const Napi::CallbackInfo& info);
+Napi::Value QueryCollectManySync(const Napi::CallbackInfo& info);
+Napi::Value QueryCollectMany(const Napi::CallbackInfo& info);
 
 // Serialization (JS -> C++, runs on main/V8 thread)
 std::shared_ptr<ExprNode> SerializeExpr(Napi::Object expr);
@@ -52,4 +106,18 @@ std::vector<PlanStep> SerializePlan(Napi::Array ops);
 
 // Graph emission (C++, runs on Teide thread)
 td_op_t* EmitExpr(td_graph_t* g, const std::shared_ptr<ExprNode>& node);
-td_t* ExecutePlan(td_t* tbl, const std::vector<PlanStep>& plan);
+// `cancel` (optional) is polled between the engine passes ExecutePlan issues.
+// When `profile` is given, per-node timings are recorded into it.
+td_t* ExecutePlan(td_t* tbl, const std::vector<PlanStep>& plan,
+                  const CancelToken* cancel = nullptr,
+                  PlanTree* profile = nullptr);
+// Run several plans over `tbl` as one batch: subtrees they have in common
+// are evaluated once, and plans opening with the same filters and group
+// keys share one group-by pass. One result (or error) per plan, in order.
+std::vector<td_t*> ExecutePlans(td_t* tbl, const std::vector<std::vector<PlanStep>>& plans,
+                                const CancelToken* cancel = nullptr);
+// Build and optimize `plan` without executing it. Returns TD_OK or the
+// td_err_t that stopped it.
+int ExplainPlan(td_t* tbl, const std::vector<PlanStep>& plan, PlanTree* out);
+// PlanTree -> nested JS objects (V8 thread).
+Napi::Value PlanTreeToJS(Napi::Env env, const PlanTree& tree);
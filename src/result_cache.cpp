@@ -0,0 +1,180 @@
+// result_cache.h MUST come first -- it pulls in teide_thread.h which brings
+// <napi.h>, <atomic>, and other C++ headers before the C-atomic shim.
+#include "result_cache.h"
+#include "query.h"
+#include "compat.h"
+
+#include <algorithm>
+#include <cstring>
+
+// ---------------------------------------------------------------------------
+// Canonical plan form
+// ---------------------------------------------------------------------------
+
+// Length-prefixed strings and raw double bits keep the encoding unambiguous.
+static void PutStr(std::string& out, const std::string& s) {
+    out += std::to_string(s.size());
+    out += ':';
+    out += s;
+}
+
+static void PutNum(std::string& out, double v) {
+    uint64_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    out += std::to_string(bits);
+    out += ';';
+}
+
+static void PutExpr(std::string& out, const ExprNode* e) {
+    if (!e) {
+        out += '~';
+        return;
+    }
+    out += '(';
+    out += std::to_string((int)e->kind);
+    out += ',';
+    PutStr(out, e->str_val);
+    PutNum(out, e->num_val);
+    out += e->bool_val ? 'T' : 'F';
+    out += std::to_string(e->opcode);
+    out += ',';
+    out += std::to_string((int)e->lit_type);
+    out += '[';
+    for (double v : e->num_list) PutNum(out, v);
+    out += "][";
+    for (const auto& s : e->str_list) PutStr(out, s);
+    out += ']';
+    PutExpr(out, e->left.get());
+    PutExpr(out, e->right.get());
+    out += '[';
+    for (const auto& a : e->args) PutExpr(out, a.get());
+    out += ']';
+    out += ')';
+}
+
+static std::string StepKey(const PlanStep& step) {
+    std::string out;
+    out += std::to_string((int)step.type);
+    out += ',';
+    PutExpr(out, step.filter_expr.get());
+    for (const auto& k : step.group_keys) PutStr(out, k);
+    for (const auto& e : step.group_key_exprs) PutExpr(out, e.get());
+    out += '|';
+    for (const auto& a : step.agg_exprs) PutExpr(out, a.get());
+    out += '|';
+    for (size_t i = 0; i < step.sort_cols.size(); i++) {
+        PutStr(out, step.sort_cols[i]);
+        out += i < step.sort_descs.size() && step.sort_descs[i] ? 'D' : 'A';
+    }
+    out += '|';
+    out += std::to_string(step.head_n);
+    out += '|';
+    for (const auto& c : step.col_exprs) PutExpr(out, c.get());
+    return out;
+}
+
+std::string ResultCache::ExprKey(const ExprNode* e) {
+    std::string out;
+    PutExpr(out, e);
+    return out;
+}
+
+std::string ResultCache::Key(uint64_t table_id, uint64_t version,
+                             const std::vector<PlanStep>& plan) {
+    std::string key = std::to_string(table_id) + '.' + std::to_string(version) + '/';
+    std::vector<std::string> filters;
+    for (size_t i = 0; i <= plan.size(); i++) {
+        if (i < plan.size() && plan[i].type == STEP_FILTER) {
+            filters.push_back(StepKey(plan[i]));
+            continue;
+        }
+        std::sort(filters.begin(), filters.end());
+        for (const auto& f : filters) PutStr(key, f);
+        filters.clear();
+        if (i < plan.size()) PutStr(key, StepKey(plan[i]));
+    }
+    return key;
+}
+
+// ---------------------------------------------------------------------------
+// Entries
+// ---------------------------------------------------------------------------
+
+td_t* ResultCache::Get(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+        misses_++;
+        return nullptr;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second);
+    hits_++;
+    td_retain(it->second->result);
+    return it->second->result;
+}
+
+void ResultCache::Unlink(std::list<Entry>::iterator it, std::vector<td_t*>& dropped) {
+    bytes_ -= it->bytes;
+    dropped.push_back(it->result);
+    index_.erase(it->key);
+    lru_.erase(it);
+}
+
+void ResultCache::Put(const std::string& key, uint64_t table_id, td_t* result) {
+    if (!result || TD_IS_ERR(result)) return;
+    size_t bytes = td_heap_bytes(result);
+    if (bytes > max_bytes_) return;
+
+    std::vector<td_t*> dropped;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (index_.count(key)) return;  // an identical query finished first
+        td_retain(result);
+        lru_.push_front(Entry{key, table_id, result, bytes});
+        index_.emplace(key, lru_.begin());
+        bytes_ += bytes;
+        while (bytes_ > max_bytes_) {
+            Unlink(std::prev(lru_.end()), dropped);
+            evictions_++;
+        }
+    }
+    // Outside the lock: freeing a large table must not stall lookups.
+    for (td_t* t : dropped) td_release(t);
+}
+
+void ResultCache::DropTable(uint64_t table_id) {
+    std::vector<td_t*> dropped;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        for (auto it = lru_.begin(); it != lru_.end();) {
+            auto next = std::next(it);
+            if (it->table_id == table_id) Unlink(it, dropped);
+            it = next;
+        }
+    }
+    for (td_t* t : dropped) td_release(t);
+}
+
+void ResultCache::Clear() {
+    std::vector<td_t*> dropped;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        for (auto& e : lru_) dropped.push_back(e.result);
+        lru_.clear();
+        index_.clear();
+        bytes_ = 0;
+    }
+    for (td_t* t : dropped) td_release(t);
+}
+
+ResultCache::Stats ResultCache::stats() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    Stats s;
+    s.entries = lru_.size();
+    s.bytes = bytes_;
+    s.max_bytes = max_bytes_;
+    s.hits = hits_;
+    s.misses = misses_;
+    s.evictions = evictions_;
+    return s;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+// teide_thread.h pulls in <napi.h> and C++ standard headers.
+// These must come before compat.h's C-atomic shim.
+#include "teide_thread.h"
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Forward-declare td_t (C union defined in td.h, included via compat.h in .cpp files).
+extern "C" { typedef union td_t td_t; }
+
+struct PlanStep;
+struct ExprNode;
+
+// Query results of one context, keyed by the source table's identity and
+// version plus a canonical form of the plan, and shared by refcount.
+// Least recently used entries are evicted once the heap bytes held by the
+// cached tables exceed the budget. Get() may run on any thread; Put(),
+// DropTable() and Clear() release tables and so run on the Teide thread
+// that owns the heap they live in.
+class ResultCache {
+public:
+    struct Stats {
+        size_t entries = 0;
+        size_t bytes = 0;
+        size_t max_bytes = 0;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+    };
+
+    explicit ResultCache(size_t max_bytes) : max_bytes_(max_bytes) {}
+
+    // Canonical key: adjacent filter steps commute, so they are ordered.
+    static std::string Key(uint64_t table_id, uint64_t version,
+                           const std::vector<PlanStep>& plan);
+    // Canonical form of one expression: equal forms compute equal columns.
+    static std::string ExprKey(const ExprNode* e);
+
+    // New reference to the cached result, or nullptr.
+    td_t* Get(const std::string& key);
+    // Retains `result`; tables larger than the whole budget are not kept.
+    void Put(const std::string& key, uint64_t table_id, td_t* result);
+    // Forget every result computed from table `table_id`.
+    void DropTable(uint64_t table_id);
+    void Clear();
+    Stats stats();
+
+private:
+    struct Entry {
+        std::string key;
+        uint64_t table_id;
+        td_t* result;
+        size_t bytes;
+    };
+
+    void Unlink(std::list<Entry>::iterator it, std::vector<td_t*>& dropped);
+
+    std::mutex mtx_;
+    std::list<Entry> lru_;   // most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+    size_t max_bytes_;
+    size_t bytes_ = 0;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+    uint64_t evictions_ = 0;
+};
@@ -1,11 +1,12 @@
 // series.h MUST come first -- it pulls in teide_thread.h which brings
 // <napi.h>, <atomic>, and other C++ headers before the C-atomic shim.
 #include "series.h"
+#include "addon_data.h"
 #include "compat.h"
 
 #include <cstring>
+#include <vector>
 
-Napi::FunctionReference NativeSeries::constructor_;
 
 Napi::Object NativeSeries::Init(Napi::Env env, Napi::Object exports) {
     Napi::Function func = DefineClass(env, "NativeSeries", {
@@ -16,10 +17,10 @@ Napi::Object NativeSeries::Init(Napi::Env env, Napi::Object exports) {
         InstanceAccessor("nullBitmap", &NativeSeries::GetNullBitmap, nullptr),
         InstanceAccessor("indices", &NativeSeries::GetIndices, nullptr),
         InstanceAccessor("dictionary", &NativeSeries::GetDictionary, nullptr),
+        InstanceAccessor("dictionaryBuffer", &NativeSeries::GetDictionaryBuffer, nullptr),
     });
 
-    constructor_ = Napi::Persistent(func);
-    constructor_.SuppressDestruct();
+    AddonData::Of(env).series = Napi::Persistent(func);
 
     exports.Set("NativeSeries", func);
     return exports;
@@ -27,13 +28,15 @@ Napi::Object NativeSeries::Init(Napi::Env env, Napi::Object exports) {
 
 Napi::Object NativeSeries::Create(Napi::Env env, td_t* vec,
                                    const std::string& name, int8_t dtype,
-                                   TeideThread* thread) {
-    Napi::Object obj = constructor_.New({
+                                   TeideThread* thread,
+                                   std::shared_ptr<std::atomic<bool>> exposed) {
+    Napi::Object obj = AddonData::Of(env).series.New({
         Napi::External<td_t>::New(env, vec),
         Napi::String::New(env, name),
         Napi::Number::New(env, dtype),
         Napi::External<TeideThread>::New(env, thread),
     });
+    Unwrap(obj)->exposed_ = std::move(exposed);
     return obj;
 }
 
@@ -129,8 +132,8 @@ Napi::Value NativeSeries::GetData(const Napi::CallbackInfo& info) {
             return env.Undefined();
     }
 
-    Napi::Value result = CreateZeroCopyArray(env, data_ptr, length,
-                                              elem_size, arr_type);
+    Napi::Value result = CreateDataArray(env, data_ptr, length,
+                                          elem_size, arr_type);
     cached_data_ = Napi::Persistent(result);
     return result;
 }
@@ -148,9 +151,9 @@ Napi::Value NativeSeries::GetNullBitmap(const Napi::CallbackInfo& info) {
     if (attrs & TD_ATTR_NULLMAP_EXT) {
         td_t* ext = vec_->ext_nullmap;
         if (!ext) return env.Null();
-        // External nullmap is a vector of bytes; expose as zero-copy Uint8Array
+        // External nullmap is a vector of bytes; expose as a Uint8Array
         int64_t nbytes = (vec_->len + 7) / 8;
-        return CreateZeroCopyArray(env, td_data(ext), nbytes, 1, napi_uint8_array);
+        return CreateDataArray(env, td_data(ext), nbytes, 1, napi_uint8_array);
     }
 
     // Inline nullmap: 16 bytes in the header -- copy to avoid aliasing issues
@@ -165,44 +168,190 @@ Napi::Value NativeSeries::GetNullBitmap(const Napi::CallbackInfo& info) {
 
 // ---------------------------------------------------------------------------
 // Symbol column accessors
+//
+// Symbol ids index the process-wide symbol table, which may hold far more
+// strings than any one column uses. Columns are exported with a compact
+// local dictionary instead: `indices` are positions in the column's own
+// distinct values (first-seen order), so decoding scales with the column's
+// cardinality rather than the process's.
 // ---------------------------------------------------------------------------
 
-Napi::Value NativeSeries::GetIndices(const Napi::CallbackInfo& info) {
-    Napi::Env env = info.Env();
+namespace {
 
-    if (dtype_ != TD_SYM) {
-        Napi::TypeError::New(env, ".indices is only available on symbol columns")
-            .ThrowAsJavaScriptException();
-        return env.Undefined();
+// Global symbol id -> local code. Direct tables for narrow columns, open
+// addressing otherwise.
+class LocalCodeMap {
+public:
+    explicit LocalCodeMap(uint8_t width) {
+        if (width == TD_SYM_W8) direct_.assign(256, -1);
+        else if (width == TD_SYM_W16) direct_.assign(65536, -1);
+        else slots_.assign(1024, Slot{0, -1});
     }
 
-    int64_t length = vec_->len;
-    void* data_ptr = ResolveDataPtr(vec_, dtype_);
+    // Local code of `id`, assigning the next one on first sight
+    uint32_t code(uint64_t id) {
+        if (!direct_.empty()) {
+            int32_t& c = direct_[id];
+            if (c < 0) { c = (int32_t)ids.size(); ids.push_back(id); }
+            return (uint32_t)c;
+        }
+        if ((ids.size() + 1) * 2 > slots_.size()) grow();
+        size_t mask = slots_.size() - 1;
+        size_t i = hash(id) & mask;
+        while (slots_[i].code >= 0) {
+            if (slots_[i].id == id) return (uint32_t)slots_[i].code;
+            i = (i + 1) & mask;
+        }
+        slots_[i] = Slot{id, (int64_t)ids.size()};
+        ids.push_back(id);
+        return (uint32_t)slots_[i].code;
+    }
 
+    std::vector<uint64_t> ids;   // local code -> global symbol id
+
+private:
+    struct Slot { uint64_t id; int64_t code; };
+
+    static size_t hash(uint64_t x) {
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        return (size_t)x;
+    }
+
+    void grow() {
+        std::vector<Slot> old;
+        old.swap(slots_);
+        slots_.assign(old.size() * 2, Slot{0, -1});
+        size_t mask = slots_.size() - 1;
+        for (const Slot& e : old) {
+            if (e.code < 0) continue;
+            size_t i = hash(e.id) & mask;
+            while (slots_[i].code >= 0) i = (i + 1) & mask;
+            slots_[i] = e;
+        }
+    }
+
+    std::vector<int32_t> direct_;
+    std::vector<Slot> slots_;
+};
+
+// Map every row through `map`; writes codes when `dst` is non-null.
+// Runs of one symbol skip the lookup.
+template <typename S, typename D>
+void MapCodes(const S* src, int64_t n, LocalCodeMap& map, D* dst) {
+    uint64_t last = 0;
+    D last_code = 0;
+    bool have = false;
+    for (int64_t i = 0; i < n; i++) {
+        uint64_t id = (uint64_t)src[i];
+        if (!have || id != last) {
+            last = id;
+            last_code = (D)map.code(id);
+            have = true;
+        }
+        if (dst) dst[i] = last_code;
+    }
+}
+
+template <typename S>
+void MapCodesTo(const S* src, int64_t n, LocalCodeMap& map, void* dst, size_t elem) {
+    switch (elem) {
+        case 1:  MapCodes(src, n, map, (uint8_t*)dst); break;
+        case 2:  MapCodes(src, n, map, (uint16_t*)dst); break;
+        default: MapCodes(src, n, map, (uint32_t*)dst); break;
+    }
+}
+
+void MapColumn(const void* data, uint8_t width, int64_t n,
+               LocalCodeMap& map, void* dst, size_t elem) {
+    switch (width) {
+        case TD_SYM_W8:  MapCodesTo((const uint8_t*)data, n, map, dst, elem); break;
+        case TD_SYM_W16: MapCodesTo((const uint16_t*)data, n, map, dst, elem); break;
+        case TD_SYM_W32: MapCodesTo((const uint32_t*)data, n, map, dst, elem); break;
+        default:         MapCodesTo((const int64_t*)data, n, map, dst, elem); break;
+    }
+}
+
+} // namespace
+
+bool NativeSeries::BuildLocalDict(Napi::Env env) {
+    if (!cached_codes_.IsEmpty()) return true;
+
+    int64_t length = vec_->len;
+    const void* data = ResolveDataPtr(vec_, dtype_);
     uint8_t width = vec_->attrs & TD_SYM_W_MASK;
+
+    // Pass 1 collects the distinct symbols, pass 2 writes codes at the
+    // narrowest width that holds them.
+    LocalCodeMap map(width);
+    MapColumn(data, width, length, map, nullptr, 4);
+    size_t ndict = map.ids.size();
+
     napi_typedarray_type arr_type;
     size_t elem_size;
+    if (ndict <= 256)        { arr_type = napi_uint8_array;  elem_size = 1; }
+    else if (ndict <= 65536) { arr_type = napi_uint16_array; elem_size = 2; }
+    else                     { arr_type = napi_uint32_array; elem_size = 4; }
+
+    auto codes_ab = Napi::ArrayBuffer::New(env, (size_t)length * elem_size);
+    MapColumn(data, width, length, map, codes_ab.Data(), elem_size);
+    napi_value codes;
+    if (napi_create_typedarray(env, arr_type, (size_t)length, codes_ab, 0, &codes) != napi_ok) {
+        Napi::Error::New(env, "Failed to create TypedArray").ThrowAsJavaScriptException();
+        return false;
+    }
 
-    switch (width) {
-        case TD_SYM_W8:
-            arr_type = napi_uint8_array;
-            elem_size = 1;
-            break;
-        case TD_SYM_W16:
-            arr_type = napi_uint16_array;
-            elem_size = 2;
-            break;
-        case TD_SYM_W32:
-            arr_type = napi_uint32_array;
-            elem_size = 4;
-            break;
-        default:
-            Napi::TypeError::New(env, "Unsupported symbol width")
-                .ThrowAsJavaScriptException();
-            return env.Undefined();
+    // Dictionary strings packed back to back: entry i is
+    // bytes[offsets[i], offsets[i + 1]). This is the one copy the export
+    // makes. The column's strings are scattered through the process-wide
+    // symbol arena, interleaved with every other column's, so there is no
+    // contiguous engine buffer to wrap; packing straight into the JS-owned
+    // buffer costs one pass over the distinct values and nothing per row.
+    std::vector<td_t*> strs(ndict);
+    size_t total = 0;
+    for (size_t i = 0; i < ndict; i++) {
+        strs[i] = td_sym_str((int64_t)map.ids[i]);
+        if (strs[i]) total += td_str_len(strs[i]);
+    }
+    if (total > (size_t)INT32_MAX) {
+        Napi::RangeError::New(env, "Symbol dictionary exceeds 2 GiB")
+            .ThrowAsJavaScriptException();
+        return false;
+    }
+
+    auto bytes_ab = Napi::ArrayBuffer::New(env, total);
+    auto offs_ab = Napi::ArrayBuffer::New(env, (ndict + 1) * sizeof(int32_t));
+    uint8_t* bytes = (uint8_t*)bytes_ab.Data();
+    int32_t* offs = (int32_t*)offs_ab.Data();
+    size_t pos = 0;
+    for (size_t i = 0; i < ndict; i++) {
+        offs[i] = (int32_t)pos;
+        if (!strs[i]) continue;
+        size_t len = td_str_len(strs[i]);
+        memcpy(bytes + pos, td_str_ptr(strs[i]), len);
+        pos += len;
     }
+    offs[ndict] = (int32_t)pos;
+
+    cached_codes_ = Napi::Persistent(Napi::Value(env, codes));
+    cached_dict_bytes_ = Napi::Persistent(
+        Napi::Value(Napi::Uint8Array::New(env, total, bytes_ab, 0)));
+    cached_dict_offsets_ = Napi::Persistent(
+        Napi::Value(Napi::Int32Array::New(env, ndict + 1, offs_ab, 0)));
+    return true;
+}
+
+Napi::Value NativeSeries::GetIndices(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
 
-    return CreateZeroCopyArray(env, data_ptr, length, elem_size, arr_type);
+    if (dtype_ != TD_SYM) {
+        Napi::TypeError::New(env, ".indices is only available on symbol columns")
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    if (!BuildLocalDict(env)) return env.Undefined();
+    return cached_codes_.Value();
 }
 
 Napi::Value NativeSeries::GetDictionary(const Napi::CallbackInfo& info) {
@@ -213,20 +362,37 @@ Napi::Value NativeSeries::GetDictionary(const Napi::CallbackInfo& info) {
             .ThrowAsJavaScriptException();
         return env.Undefined();
     }
+    if (!cached_dict_.IsEmpty()) return cached_dict_.Value();
+    if (!BuildLocalDict(env)) return env.Undefined();
 
-    uint32_t count = td_sym_count();
+    auto bytes = cached_dict_bytes_.Value().As<Napi::Uint8Array>();
+    auto offs = cached_dict_offsets_.Value().As<Napi::Int32Array>();
+    uint32_t count = (uint32_t)offs.ElementLength() - 1;
+    const char* base = (const char*)bytes.Data();
     Napi::Array arr = Napi::Array::New(env, count);
     for (uint32_t i = 0; i < count; i++) {
-        td_t* s = td_sym_str((int64_t)i);
-        if (s) {
-            arr.Set(i, Napi::String::New(env, td_str_ptr(s), td_str_len(s)));
-        } else {
-            arr.Set(i, Napi::String::New(env, ""));
-        }
+        arr.Set(i, Napi::String::New(env, base + offs[i], (size_t)(offs[i + 1] - offs[i])));
     }
+    cached_dict_ = Napi::Persistent(Napi::Value(arr));
     return arr;
 }
 
+Napi::Value NativeSeries::GetDictionaryBuffer(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (dtype_ != TD_SYM) {
+        Napi::TypeError::New(env, ".dictionaryBuffer is only available on symbol columns")
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    if (!BuildLocalDict(env)) return env.Undefined();
+
+    auto out = Napi::Object::New(env);
+    out.Set("bytes", cached_dict_bytes_.Value());
+    out.Set("offsets", cached_dict_offsets_.Value());
+    return out;
+}
+
 // ---------------------------------------------------------------------------
 // Helpers
 // ---------------------------------------------------------------------------
@@ -236,6 +402,29 @@ struct BufRef {
     std::shared_ptr<std::atomic<bool>> heap_alive;
 };
 
+// A result-cache entry is the same td_t for every caller of its query, so
+// a write through one caller's array must not reach the others: those
+// columns are copied into JS memory. Anything else is viewed in place,
+// and its table stops caching results, since JS may now change the rows
+// behind the engine's back.
+Napi::Value NativeSeries::CreateDataArray(
+    Napi::Env env, void* data, int64_t length,
+    size_t elem_size, napi_typedarray_type arr_type) {
+
+    if (exposed_) {
+        exposed_->store(true);
+        return CreateZeroCopyArray(env, data, length, elem_size, arr_type);
+    }
+    auto ab = Napi::ArrayBuffer::New(env, (size_t)length * elem_size);
+    if (length > 0) memcpy(ab.Data(), data, (size_t)length * elem_size);
+    napi_value typed_arr;
+    if (napi_create_typedarray(env, arr_type, (size_t)length, ab, 0, &typed_arr) != napi_ok) {
+        Napi::Error::New(env, "Failed to create TypedArray").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    return Napi::Value(env, typed_arr);
+}
+
 Napi::Value NativeSeries::CreateZeroCopyArray(
     Napi::Env env, void* data, int64_t length,
     size_t elem_size, napi_typedarray_type arr_type) {
@@ -3,6 +3,7 @@
 // teide_thread.h pulls in <napi.h> and C++ standard headers.
 // These must come before compat.h's C-atomic shim.
 #include "teide_thread.h"
+#include <memory>
 #include <string>
 
 // Forward-declare td_t (C union defined in td.h, included via compat.h
@@ -14,8 +15,11 @@ class TeideThread;
 class NativeSeries : public Napi::ObjectWrap<NativeSeries> {
 public:
     static Napi::Object Init(Napi::Env env, Napi::Object exports);
+    // `exposed` is the owning table's flag, raised when data is handed out
+    // zero-copy; without one (a result-cache entry) data is copied out.
     static Napi::Object Create(Napi::Env env, td_t* vec, const std::string& name,
-                               int8_t dtype, TeideThread* thread);
+                               int8_t dtype, TeideThread* thread,
+                               std::shared_ptr<std::atomic<bool>> exposed);
     NativeSeries(const Napi::CallbackInfo& info);
 
     td_t* ptr() const { return vec_; }
@@ -28,16 +32,27 @@ private:
     Napi::Value GetNullBitmap(const Napi::CallbackInfo& info);
     Napi::Value GetIndices(const Napi::CallbackInfo& info);
     Napi::Value GetDictionary(const Napi::CallbackInfo& info);
+    Napi::Value GetDictionaryBuffer(const Napi::CallbackInfo& info);
 
     Napi::Value CreateZeroCopyArray(Napi::Env env, void* data, int64_t length,
                                      size_t elem_size, napi_typedarray_type arr_type);
+    // Zero-copy view, or a JS-owned copy for a result-cache entry
+    Napi::Value CreateDataArray(Napi::Env env, void* data, int64_t length,
+                                size_t elem_size, napi_typedarray_type arr_type);
     static void* ResolveDataPtr(td_t* vec, int8_t dtype);
+    bool BuildLocalDict(Napi::Env env);
 
     td_t* vec_;
     std::string name_;
     int8_t dtype_;
     TeideThread* thread_;
     std::shared_ptr<std::atomic<bool>> heap_alive_;
+    std::shared_ptr<std::atomic<bool>> exposed_;
     Napi::Reference<Napi::Value> cached_data_;
-    static Napi::FunctionReference constructor_;
+    // Symbol columns: row codes into a dictionary of this column's own
+    // distinct values, built on first access.
+    Napi::Reference<Napi::Value> cached_codes_;
+    Napi::Reference<Napi::Value> cached_dict_bytes_;
+    Napi::Reference<Napi::Value> cached_dict_offsets_;
+    Napi::Reference<Napi::Value> cached_dict_;
 };
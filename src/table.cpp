@@ -2,9 +2,17 @@
 // <napi.h>, <atomic>, and other C++ headers before the C-atomic shim.
 #include "table.h"
 #include "series.h"
+#include "mview.h"
+#include "cancel.h"
+#include "result_cache.h"
+#include "addon_data.h"
 #include "compat.h"
 
-Napi::FunctionReference NativeTable::constructor_;
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+std::atomic<uint64_t> NativeTable::next_id_{1};
 
 Napi::Object NativeTable::Init(Napi::Env env, Napi::Object exports) {
     Napi::Function func = DefineClass(env, "NativeTable", {
@@ -12,23 +20,39 @@ Napi::Object NativeTable::Init(Napi::Env env, Napi::Object exports) {
         InstanceAccessor("nCols", &NativeTable::GetNCols, nullptr),
         InstanceAccessor("columns", &NativeTable::GetColumns, nullptr),
         InstanceMethod("col", &NativeTable::Col),
+        InstanceMethod("writeCsvSync", &NativeTable::WriteCsvSync),
+        InstanceMethod("writeCsv", &NativeTable::WriteCsv),
+        InstanceMethod("writeCsvStream", &NativeTable::WriteCsvStream),
+        InstanceMethod("append", &NativeTable::Append),
+        InstanceMethod("materialize", &NativeTable::Materialize),
+        InstanceMethod("publish", &NativeTable::Publish),
     });
-    constructor_ = Napi::Persistent(func);
-    constructor_.SuppressDestruct();
+    AddonData::Of(env).table = Napi::Persistent(func);
     exports.Set("NativeTable", func);
     return exports;
 }
 
-Napi::Object NativeTable::Create(Napi::Env env, td_t* tbl, TeideThread* thread) {
-    Napi::Object obj = constructor_.New({
+// Takes over the caller's reference to tbl. Tables are wrapped fresh from
+// the engine, so the wrapper is usually the sole owner and Append() can
+// grow the columns in place; a result also held by the result cache is
+// copied on its first append instead. `cached`: tbl is (or may be) a
+// result-cache entry handed to every caller of the same query, so its
+// columns must not be exposed as writable views.
+Napi::Object NativeTable::Create(Napi::Env env, td_t* tbl, TeideThread* thread,
+                                 bool cached) {
+    Napi::Object obj = AddonData::Of(env).table.New({
         Napi::External<td_t>::New(env, tbl),
         Napi::External<TeideThread>::New(env, thread),
     });
+    Unwrap(obj)->cached_ = cached;
+    if (tbl) td_release(tbl);  // the constructor retained it
     return obj;
 }
 
 NativeTable::NativeTable(const Napi::CallbackInfo& info)
-    : Napi::ObjectWrap<NativeTable>(info), tbl_(nullptr), thread_(nullptr) {
+    : Napi::ObjectWrap<NativeTable>(info), tbl_(nullptr), thread_(nullptr),
+      id_(next_id_.fetch_add(1)),
+      exposed_(std::make_shared<std::atomic<bool>>(false)) {
     Napi::Env env = info.Env();
     if (info.Length() < 2) {
         Napi::TypeError::New(env, "NativeTable: internal constructor requires 2 arguments")
@@ -42,8 +66,11 @@ NativeTable::NativeTable(const Napi::CallbackInfo& info)
     if (tbl_) td_retain(tbl_);
 }
 
+// A shared table (see Publish) lives outside every heap and may be
+// released after its context is gone.
 NativeTable::~NativeTable() {
-    if (tbl_ && heap_alive_ && heap_alive_->load()) td_release(tbl_);
+    if (tbl_ && (tbl_->mmod == 3 || (heap_alive_ && heap_alive_->load())))
+        td_release(tbl_);
 }
 
 Napi::Value NativeTable::GetNRows(const Napi::CallbackInfo& info) {
@@ -94,5 +121,451 @@ Napi::Value NativeTable::Col(const Napi::CallbackInfo& info) {
     }
 
     int8_t dtype = td_type(col);
-    return NativeSeries::Create(env, col, name, dtype, thread_);
+    return NativeSeries::Create(env, col, name, dtype, thread_,
+                                cached_ ? nullptr : exposed_);
+}
+
+// ---------------------------------------------------------------------------
+// Append and materialized views
+// ---------------------------------------------------------------------------
+
+// Appends run synchronously on the Teide thread, after any queued query.
+// Queries still in flight hold their own reference to the table, so the
+// engine copies instead of growing it under them; otherwise the columns
+// grow in place. Every live view is folded with the batch in the same
+// dispatch, so a view never lags its table, and cached results of queries
+// over the old rows are dropped.
+Napi::Value NativeTable::Append(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (!check_writable(env)) return env.Undefined();
+    if (info.Length() < 1 || !info[0].IsObject() ||
+        !info[0].As<Napi::Object>().InstanceOf(AddonData::Of(env).table.Value())) {
+        Napi::TypeError::New(env, "Expected a table to append").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    if (tbl_->mmod == 3) {
+        Napi::Error::New(env, "Table is read-only: it was opened from a shared handle")
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    td_t* batch = Napi::ObjectWrap<NativeTable>::Unwrap(info[0].As<Napi::Object>())->tbl_;
+
+    std::vector<std::shared_ptr<MViewState>> views;
+    std::vector<std::weak_ptr<MViewState>> live;
+    for (auto& w : views_) {
+        if (auto v = w.lock()) {
+            views.push_back(v);
+            live.push_back(w);
+        }
+    }
+    views_.swap(live);
+
+    td_t* tbl = tbl_;
+    uint64_t id = id_;
+    ResultCache* cache = thread_->result_cache();
+    void* result = thread_->dispatch_sync([tbl, batch, views, id, cache]() -> void* {
+        td_t* out = td_table_append(tbl, batch);
+        if (!out || TD_IS_ERR(out)) return out ? out : TD_ERR_PTR(TD_ERR_OOM);
+        for (auto& v : views) v->Apply(out, batch);
+        if (cache) cache->DropTable(id);
+        return out;
+    });
+
+    td_t* out = (td_t*)result;
+    if (TD_IS_ERR(out)) {
+        Napi::Error::New(env, std::string("Failed to append: ") +
+                              td_err_str(TD_ERR_CODE(out))).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    tbl_ = out;  // td_table_append consumed our reference to the old table
+    version_++;
+    return env.Undefined();
+}
+
+// materialize(keys: string[], aggs: { op: number, col: string }[])
+Napi::Value NativeTable::Materialize(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (!check_writable(env)) return env.Undefined();
+    if (info.Length() < 2 || !info[0].IsArray() || !info[1].IsArray()) {
+        Napi::TypeError::New(env, "materialize requires (keys[], aggs[])").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    Napi::Array keys = info[0].As<Napi::Array>();
+    Napi::Array aggs = info[1].As<Napi::Array>();
+    if (keys.Length() == 0 || keys.Length() > 255 || aggs.Length() > 255) {
+        Napi::RangeError::New(env, "materialize requires 1-255 keys and at most 255 aggregations")
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    std::vector<std::string> key_names, agg_names;
+    std::vector<uint16_t> agg_ops;
+    for (uint32_t i = 0; i < keys.Length(); i++)
+        key_names.push_back(keys.Get(i).As<Napi::String>().Utf8Value());
+    for (uint32_t i = 0; i < aggs.Length(); i++) {
+        Napi::Object a = aggs.Get(i).As<Napi::Object>();
+        agg_ops.push_back((uint16_t)a.Get("op").As<Napi::Number>().Uint32Value());
+        agg_names.push_back(a.Get("col").As<Napi::String>().Utf8Value());
+    }
+
+    auto state = std::make_shared<MViewState>();
+    state->agg_ops = agg_ops;
+    td_t* tbl = tbl_;
+    void* result = thread_->dispatch_sync([tbl, state, key_names, agg_names]() -> void* {
+        for (const auto& n : key_names) state->key_syms.push_back(td_sym_find(n.c_str(), n.size()));
+        for (const auto& n : agg_names) state->agg_syms.push_back(td_sym_find(n.c_str(), n.size()));
+        td_err_t err = (td_err_t)state->Build(tbl);
+        return err == TD_OK ? nullptr : TD_ERR_PTR(err);
+    });
+
+    if (result) {
+        td_err_t err = TD_ERR_CODE((td_t*)result);
+        std::string msg = err == TD_ERR_SCHEMA ? "Column not found"
+                        : err == TD_ERR_NYI ? "Unsupported key, aggregation or column type"
+                        : td_err_str(err);
+        Napi::Error::New(env, "Failed to materialize view: " + msg).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    views_.push_back(state);
+    return NativeMView::Create(env, state, thread_);
+}
+
+// ---------------------------------------------------------------------------
+// Shared tables
+// ---------------------------------------------------------------------------
+
+// One registry per process: the addon is loaded once and every context and
+// worker_thread sees the same entries. Each entry holds one reference to a
+// td_table_share() copy, which no Teide heap owns, and one td_sym_init()
+// reference: with every context destroyed the symbol table would otherwise
+// be torn down and the copy's symbol columns would decode against whatever
+// the next context interns.
+static std::mutex g_shared_mtx;
+static std::unordered_map<std::string, td_t*> g_shared;
+static uint64_t g_shared_next = 1;
+
+td_t* SharedTableOpen(const std::string& handle) {
+    std::lock_guard<std::mutex> lock(g_shared_mtx);
+    auto it = g_shared.find(handle);
+    if (it == g_shared.end()) return nullptr;
+    td_retain(it->second);
+    return it->second;
+}
+
+bool SharedTableRelease(const std::string& handle) {
+    td_t* tbl;
+    {
+        std::lock_guard<std::mutex> lock(g_shared_mtx);
+        auto it = g_shared.find(handle);
+        if (it == g_shared.end()) return false;
+        tbl = it->second;
+        g_shared.erase(it);
+    }
+    td_release(tbl);  // tables opened from the handle keep their own reference
+    td_sym_destroy();
+    return true;
+}
+
+// Copies the heap-resident columns once, on the Teide thread that owns
+// them; mapped columns and an already shared table are not copied.
+Napi::Value NativeTable::Publish(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (!check_writable(env)) return env.Undefined();
+
+    td_t* tbl = tbl_;
+    void* result = thread_->dispatch_sync([tbl]() -> void* {
+        return td_table_share(tbl);
+    });
+
+    td_t* shared = (td_t*)result;
+    if (!shared || TD_IS_ERR(shared)) {
+        td_err_t err = shared ? TD_ERR_CODE(shared) : TD_ERR_OOM;
+        std::string msg = err == TD_ERR_NYI ? "Unsupported column type" : td_err_str(err);
+        Napi::Error::New(env, "Failed to publish table: " + msg).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    std::string handle;
+    td_sym_init();  // released with the entry in SharedTableRelease
+    {
+        std::lock_guard<std::mutex> lock(g_shared_mtx);
+        handle = "teide-table:" + std::to_string(g_shared_next++);
+        g_shared.emplace(handle, shared);
+    }
+    return Napi::String::New(env, handle);
+}
+
+// unpublish(handle) -> whether the handle was still published
+Napi::Value TableUnpublish(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Expected a shared table handle").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    return Napi::Boolean::New(env, SharedTableRelease(info[0].As<Napi::String>().Utf8Value()));
+}
+
+// ---------------------------------------------------------------------------
+// CSV export
+// ---------------------------------------------------------------------------
+
+struct CsvWriteOpts {
+    char delimiter = ',';
+    bool header = true;
+};
+
+// `{ delimiter?, header? }`; the same object carries the cancel options.
+static bool ParseCsvWriteOpts(Napi::Env env, Napi::Value v, CsvWriteOpts& out) {
+    if (v.IsUndefined() || v.IsNull()) return true;
+    if (!v.IsObject()) {
+        Napi::TypeError::New(env, "writeCsv options must be an object").ThrowAsJavaScriptException();
+        return false;
+    }
+    Napi::Object o = v.As<Napi::Object>();
+    Napi::Value d = o.Get("delimiter");
+    if (!d.IsUndefined()) {
+        std::string s = d.IsString() ? d.As<Napi::String>().Utf8Value() : std::string();
+        if (s.size() != 1 || s[0] == '"' || s[0] == '\n' || s[0] == '\r') {
+            Napi::TypeError::New(env, "delimiter must be a single ASCII character other than a quote or newline")
+                .ThrowAsJavaScriptException();
+            return false;
+        }
+        out.delimiter = s[0];
+    }
+    Napi::Value h = o.Get("header");
+    if (!h.IsUndefined()) out.header = h.ToBoolean();
+    return true;
+}
+
+static std::string CsvWriteError(td_err_t err) {
+    return std::string("Failed to write CSV: ") + td_err_str(err);
+}
+
+bool NativeTable::check_writable(Napi::Env env) {
+    if (!thread_->is_running()) {
+        Napi::Error::New(env, "Context has been destroyed").ThrowAsJavaScriptException();
+        return false;
+    }
+    return true;
+}
+
+Napi::Value NativeTable::WriteCsvSync(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (!check_writable(env)) return env.Undefined();
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Expected string path").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    std::string path = info[0].As<Napi::String>().Utf8Value();
+    CsvWriteOpts opts;
+    if (!ParseCsvWriteOpts(env, info[1], opts)) return env.Undefined();
+    auto token = CancelTokenFromOpts(info[1]);
+
+    td_t* tbl = tbl_;
+    void* result = thread_->dispatch_sync([tbl, path, opts]() -> void* {
+        td_err_t err = td_write_csv_opts(tbl, path.c_str(), opts.delimiter, opts.header);
+        return err == TD_OK ? nullptr : TD_ERR_PTR(err);
+    }, token);
+
+    if (result) {
+        Napi::Error::New(env, CsvWriteError(TD_ERR_CODE((td_t*)result))).ThrowAsJavaScriptException();
+    }
+    return env.Undefined();
+}
+
+Napi::Value NativeTable::WriteCsv(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (!check_writable(env)) return env.Undefined();
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Expected string path").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    std::string path = info[0].As<Napi::String>().Utf8Value();
+    CsvWriteOpts opts;
+    if (!ParseCsvWriteOpts(env, info[1], opts)) return env.Undefined();
+    auto token = CancelTokenFromOpts(info[1]);
+    auto deferred = Napi::Promise::Deferred::New(env);
+    auto tsfn = Napi::ThreadSafeFunction::New(env, Napi::Function(), "writeCsv", 0, 1);
+
+    // The JS wrapper may be collected while the write is queued.
+    td_t* tbl = tbl_;
+    td_retain(tbl);
+    thread_->dispatch_async(
+        [tbl, path, opts]() -> void* {
+            td_err_t err = td_write_csv_opts(tbl, path.c_str(), opts.delimiter, opts.header);
+            td_release(tbl);
+            return err == TD_OK ? nullptr : TD_ERR_PTR(err);
+        },
+        tsfn,
+        [deferred](Napi::Env env, void* data) {
+            if (data) {
+                deferred.Reject(Napi::Error::New(env,
+                    CsvWriteError(TD_ERR_CODE((td_t*)data))).Value());
+            } else {
+                deferred.Resolve(env.Undefined());
+            }
+        },
+        token,
+        [tbl]() { td_release(tbl); }
+    );
+
+    return deferred.Promise();
+}
+
+// Streamed CSV export. The table is written in row slices, each its own
+// work item on the Teide thread: a slice formats its rows and posts the
+// chunks to JS without waiting on the consumer, so other queries on the
+// context run between slices. The next slice is queued from the JS thread
+// only once the stream has taken every chunk handed to it so far (the chunk
+// callback returned true, or later called resume(true)). At most one slice
+// is in flight beyond what the stream has accepted.
+//
+// All fields but `aborted` are touched on the JS thread only.
+struct CsvStream : std::enable_shared_from_this<CsvStream> {
+    static constexpr int64_t kSliceRows = 1 << 18;
+
+    Napi::Env env;
+    TeideThread* thread;
+    td_t* tbl;
+    CsvWriteOpts opts;
+    std::shared_ptr<CancelToken> token;
+    Napi::ThreadSafeFunction tsfn;     // calls the chunk callback
+    Napi::Promise::Deferred deferred;
+    int64_t nrows;
+    int64_t next_row = 0;
+    int refused = 0;                   // chunks waiting for resume()
+    bool slice_queued = false;
+    bool finished = false;
+    std::atomic<bool> aborted{false};  // read by the slice's sink
+
+    CsvStream(Napi::Env e, TeideThread* thr, td_t* t, const CsvWriteOpts& o,
+              std::shared_ptr<CancelToken> tok, Napi::ThreadSafeFunction fn)
+        : env(e), thread(thr), tbl(t), opts(o), token(std::move(tok)), tsfn(fn),
+          deferred(Napi::Promise::Deferred::New(e)), nrows(td_table_nrows(t)) {}
+
+    void pump();
+    void slice_done(Napi::Env env, td_err_t err, int64_t end);
+    void finish(Napi::Env env, td_err_t err);
+    void grant(bool ok);
+};
+
+namespace {
+struct CsvSliceSink {
+    std::shared_ptr<CsvStream> stream;
+};
+}
+
+// Runs on the Teide thread: posts a copy of the chunk to JS on the
+// thread-safe function that later reports the slice, so chunks arrive in
+// order and before their slice's completion. Never waits for the consumer.
+static int CsvStreamWrite(void* ctx, const char* data, size_t len) {
+    auto& stream = ((CsvSliceSink*)ctx)->stream;
+    if (stream->aborted.load()) return 1;
+
+    auto* chunk = new std::vector<char>(data, data + len);
+    napi_status status = stream->tsfn.BlockingCall(chunk,
+        [stream](Napi::Env env, Napi::Function on_chunk, std::vector<char>* chunk) {
+            auto buf = Napi::Buffer<char>::Copy(env, chunk->data(), chunk->size());
+            delete chunk;
+            if (stream->finished) return;
+            auto resume = Napi::Function::New(env, [stream](const Napi::CallbackInfo& info) {
+                stream->grant(info.Length() > 0 && info[0].ToBoolean());
+            });
+            stream->refused++;
+            Napi::Value ret = on_chunk.Call({buf, resume});
+            if (env.IsExceptionPending()) stream->grant(false);
+            else if (ret.ToBoolean()) stream->grant(true);
+        });
+    if (status != napi_ok) {
+        delete chunk;
+        return 1;
+    }
+    return 0;
+}
+
+// Queues the next slice when nothing is in flight and the stream has room.
+void CsvStream::pump() {
+    if (finished || slice_queued || refused > 0) return;
+    if (aborted.load()) { finish(env, TD_ERR_CANCEL); return; }
+    if (!thread->is_running()) { finish(env, TD_ERR_CANCEL); return; }
+
+    int64_t start = next_row;
+    int64_t end = nrows - start > kSliceRows ? start + kSliceRows : nrows;
+    bool header = opts.header && start == 0;
+    slice_queued = true;
+    tsfn.Acquire();   // dispatch_async releases it after reporting
+    auto self = shared_from_this();
+    thread->dispatch_async(
+        [self, start, end, header]() -> void* {
+            CsvSliceSink sink{self};
+            td_err_t err = td_write_csv_rows(self->tbl, self->opts.delimiter, header,
+                                             start, end, CsvStreamWrite, &sink);
+            return err == TD_OK ? nullptr : TD_ERR_PTR(err);
+        },
+        tsfn,
+        [self, end](Napi::Env env, void* data) {
+            self->slice_done(env, data ? TD_ERR_CODE((td_t*)data) : TD_OK, end);
+        },
+        token);
+}
+
+void CsvStream::slice_done(Napi::Env env, td_err_t err, int64_t end) {
+    slice_queued = false;
+    if (err == TD_ERR_IO && aborted.load()) err = TD_ERR_CANCEL;
+    if (err != TD_OK) { finish(env, err); return; }
+    next_row = end;
+    if (next_row >= nrows) finish(env, TD_OK);
+    else pump();
+}
+
+// Settles the promise and hands the table reference back on the Teide
+// thread, where its heap lives.
+void CsvStream::finish(Napi::Env env, td_err_t err) {
+    if (finished) return;
+    finished = true;
+    aborted.store(true);
+    if (err == TD_OK) deferred.Resolve(env.Undefined());
+    else deferred.Reject(Napi::Error::New(env, CsvWriteError(err)).Value());
+
+    if (thread->is_running()) {
+        td_t* t = tbl;
+        tsfn.Acquire();
+        thread->dispatch_async([t]() -> void* { td_release(t); return nullptr; },
+                               tsfn, [](Napi::Env, void*) {});
+    }
+    tsfn.Release();
+}
+
+void CsvStream::grant(bool ok) {
+    if (finished) return;
+    if (!ok) {
+        aborted.store(true);
+        // A running slice reports the abort when it stops; otherwise settle now.
+        if (!slice_queued) finish(env, TD_ERR_CANCEL);
+        return;
+    }
+    if (refused > 0) refused--;
+    pump();
+}
+
+Napi::Value NativeTable::WriteCsvStream(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (!check_writable(env)) return env.Undefined();
+    if (info.Length() < 1 || !info[0].IsFunction()) {
+        Napi::TypeError::New(env, "Expected chunk callback").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    CsvWriteOpts opts;
+    if (!ParseCsvWriteOpts(env, info[1], opts)) return env.Undefined();
+    auto token = CancelTokenFromOpts(info[1]);
+    auto tsfn = Napi::ThreadSafeFunction::New(env, info[0].As<Napi::Function>(),
+                                              "writeCsvStream", 0, 1);
+
+    // The JS wrapper may be collected while the export runs.
+    td_retain(tbl_);
+    auto stream = std::make_shared<CsvStream>(env, thread_, tbl_, opts, token, tsfn);
+    stream->pump();
+    return stream->deferred.Promise();
 }
@@ -3,31 +3,64 @@
 // teide_thread.h pulls in <napi.h> and C++ standard headers.
 // These must come before compat.h's C-atomic shim.
 #include "teide_thread.h"
+#include <memory>
 #include <string>
+#include <vector>
 
 // Forward-declare td_t (C union defined in td.h, included via compat.h in .cpp files).
 extern "C" { typedef union td_t td_t; }
 
 class TeideThread;
+struct MViewState;
 
 class NativeTable : public Napi::ObjectWrap<NativeTable> {
 public:
     static Napi::Object Init(Napi::Env env, Napi::Object exports);
-    static Napi::Object Create(Napi::Env env, td_t* tbl, TeideThread* thread);
+    static Napi::Object Create(Napi::Env env, td_t* tbl, TeideThread* thread,
+                               bool cached = false);
     NativeTable(const Napi::CallbackInfo& info);
     ~NativeTable();
 
     td_t* ptr() const { return tbl_; }
     TeideThread* thread() const { return thread_; }
+    // Result-cache identity: results cached for (id, version) stay valid
+    // until the next Append() bumps the version.
+    uint64_t id() const { return id_; }
+    uint64_t version() const { return version_; }
+    // False once a column was handed to JS as a writable view: the rows
+    // may have changed without a version bump, so results are not cached.
+    bool cacheable() const { return !exposed_->load(); }
 
 private:
     Napi::Value GetNRows(const Napi::CallbackInfo& info);
     Napi::Value GetNCols(const Napi::CallbackInfo& info);
     Napi::Value GetColumns(const Napi::CallbackInfo& info);
     Napi::Value Col(const Napi::CallbackInfo& info);
+    Napi::Value WriteCsvSync(const Napi::CallbackInfo& info);
+    Napi::Value WriteCsv(const Napi::CallbackInfo& info);
+    Napi::Value WriteCsvStream(const Napi::CallbackInfo& info);
+    Napi::Value Append(const Napi::CallbackInfo& info);
+    Napi::Value Materialize(const Napi::CallbackInfo& info);
+    Napi::Value Publish(const Napi::CallbackInfo& info);
+    bool check_writable(Napi::Env env);
 
     td_t* tbl_;
     TeideThread* thread_;
     std::shared_ptr<std::atomic<bool>> heap_alive_;
-    static Napi::FunctionReference constructor_;
+    uint64_t id_;
+    uint64_t version_ = 0;
+    // Set by this table's series when they expose their data zero-copy.
+    std::shared_ptr<std::atomic<bool>> exposed_;
+    // The result cache may hold tbl_: series copy their data out instead.
+    bool cached_ = false;
+    // Materialized views kept current by Append(); owned by their wrappers.
+    std::vector<std::weak_ptr<MViewState>> views_;
+    static std::atomic<uint64_t> next_id_;
 };
+
+// Tables published with publish() for other contexts and worker_threads of
+// this process, by handle. Open returns a new reference, or nullptr for an
+// unknown handle; Release drops the registry's reference.
+td_t* SharedTableOpen(const std::string& handle);
+bool SharedTableRelease(const std::string& handle);
+Napi::Value TableUnpublish(const Napi::CallbackInfo& info);
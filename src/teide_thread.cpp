@@ -1,8 +1,18 @@
 // teide_thread.h MUST come first — it pulls in <napi.h>, <atomic>,
 // and other C++ headers that would conflict with the C-atomic shim.
 #include "teide_thread.h"
+#include "result_cache.h"
 #include "compat.h"
 
+void CancelToken::cancel() {
+    cancelled.store(true);
+    // The running check pairs with run_item(), which sets `running` before
+    // re-reading `cancelled`: one side always observes the other. The flag
+    // belongs to the Teide thread, so only raise it while our own item
+    // executes there.
+    if (running.load()) td_cancel(target);
+}
+
 TeideThread::TeideThread() {
     running_ = true;
     thread_ = std::thread(&TeideThread::thread_main, this);
@@ -12,62 +22,203 @@ TeideThread::~TeideThread() {
     shutdown();
 }
 
+// The worker pool is process-wide like the symbol table: only the last
+// Teide thread to exit may tear it down, or it would pull the pool from
+// under the other contexts (and worker_threads) still running queries.
+static std::atomic<int> g_live_threads{0};
+
+// Sub-millisecond queries spend most of their latency in the handoff: a
+// futex wake-up on each side costs tens of microseconds. Both sides
+// busy-wait this long for the other before they park.
+static constexpr auto kSpinFor = std::chrono::microseconds(50);
+
+// Polls `ready` until it holds or kSpinFor has passed; false on timeout.
+// On a single CPU the spinner would only delay the thread it waits for.
+template <class Ready>
+static bool SpinUntil(Ready ready) {
+    static const bool can_spin = std::thread::hardware_concurrency() > 1;
+    if (!can_spin) return ready();
+    auto until = WorkItem::Clock::now() + kSpinFor;
+    for (unsigned spin_count = 1;; spin_count++) {
+        if (ready()) return true;
+        if (spin_count % 64 == 0 && WorkItem::Clock::now() >= until) return false;
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__)
+        __asm__ volatile("yield" ::: "memory");
+#endif
+    }
+}
+
 void TeideThread::thread_main() {
     td_heap_init();
     td_sym_init();
+    cancel_ = td_cancel_self();
+    g_live_threads.fetch_add(1);
 
     while (!shutdown_.load()) {
+        // A caller issuing back-to-back sync calls enqueues the next one
+        // while we are still spinning here, and needs no wake-up.
+        SpinUntil([&] { return queued_.load() > 0 || shutdown_.load(); });
+
         std::shared_ptr<WorkItem> item;
         {
             std::unique_lock<std::mutex> lock(queue_mtx_);
-            queue_cv_.wait(lock, [&] { return !queue_.empty() || shutdown_.load(); });
+            if (queue_.empty() && !shutdown_.load()) {
+                parked_ = true;
+                queue_cv_.wait(lock, [&] { return !queue_.empty() || shutdown_.load(); });
+                parked_ = false;
+            }
             if (shutdown_.load() && queue_.empty()) break;
             if (queue_.empty()) continue;
-            item = queue_.front();
-            queue_.pop();
+            item = std::move(queue_.front());
+            queue_.pop_front();
+            queued_.fetch_sub(1);
+            item->started = WorkItem::Clock::now();
+            current_ = item;
         }
 
-        item->result = item->work();
+        run_item(*item);
+        // Captures belong to this heap: drop them here rather than whenever
+        // a recycled item is next reused.
+        item->work = nullptr;
+        item->on_skip = nullptr;
+
+        {
+            auto now = WorkItem::Clock::now();
+            auto wait = item->started - item->enqueued;
+            auto run = now - item->started;
+            td_t* res = (td_t*)item->result;
+            std::lock_guard<std::mutex> lock(queue_mtx_);
+            current_.reset();
+            if (item->counted) {
+                completed_++;
+                if (TD_IS_ERR(res) && TD_ERR_CODE(res) == TD_ERR_CANCEL) cancelled_++;
+                total_wait_ += wait;
+                total_run_ += run;
+                if (wait > max_wait_) max_wait_ = wait;
+                if (run > max_run_) max_run_ = run;
+            }
+        }
 
         if (item->on_done) {
             item->on_done(item->result);
+            item->on_done = nullptr;
         }
 
         {
             std::lock_guard<std::mutex> lock(item->mtx);
-            item->done = true;
+            item->done.store(true);
         }
         item->cv.notify_one();
     }
 
-    td_pool_destroy();
-    td_sym_destroy();
+    if (cache_) cache_->Clear();
+    if (g_live_threads.fetch_sub(1) == 1) td_pool_destroy();
+    td_sym_destroy();  // refcounted: frees only with the last user
     heap_alive_->store(false);
     td_heap_destroy();
     running_ = false;
 }
 
-void* TeideThread::dispatch_sync(std::function<void*()> work) {
-    auto item = std::make_shared<WorkItem>();
-    item->work = std::move(work);
+void TeideThread::run_item(WorkItem& item) {
+    CancelToken* tok = item.token.get();
+    if (!tok) {
+        item.result = item.work();
+        return;
+    }
+
+    tok->target = cancel_;
+    tok->running.store(true);
+    if (tok->expired()) {
+        tok->running.store(false);
+        if (item.on_skip) item.on_skip();
+        item.result = TD_ERR_PTR(TD_ERR_CANCEL);
+        return;
+    }
 
+    void* result = item.work();
+    tok->running.store(false);
+
+    if (tok->expired()) {
+        // A result produced after cancellation may be partial (skipped
+        // morsels); never hand it out.
+        td_t* res = (td_t*)result;
+        if (res && !TD_IS_ERR(res)) td_release(res);
+        result = TD_ERR_PTR(TD_ERR_CANCEL);
+        // Aborted operators free their scratch on the way out; give the
+        // emptied pools back instead of keeping the peak footprint.
+        td_heap_gc();
+    }
+    item.result = result;
+}
+
+void TeideThread::enqueue(std::shared_ptr<WorkItem> item) {
+    item->enqueued = WorkItem::Clock::now();
+    bool wake;
     {
         std::lock_guard<std::mutex> lock(queue_mtx_);
-        queue_.push(item);
+        queue_.push_back(std::move(item));
+        queued_.fetch_add(1);
+        wake = parked_;
     }
-    queue_cv_.notify_one();
+    if (wake) queue_cv_.notify_one();
+}
+
+void* TeideThread::dispatch_sync(std::function<void*()> work,
+                                 std::shared_ptr<CancelToken> token) {
+    return run_sync(std::move(work), std::move(token), true);
+}
+
+void* TeideThread::dispatch_probe(std::function<void*()> work) {
+    return run_sync(std::move(work), nullptr, false);
+}
+
+void* TeideThread::run_sync(std::function<void*()> work,
+                            std::shared_ptr<CancelToken> token, bool counted) {
+    // The caller blocks until the item is done, so one item serves every
+    // call instead of a fresh mutex and condvar per query.
+    bool pooled = !sync_item_busy_.exchange(true);
+    auto item = pooled ? sync_item_ : std::make_shared<WorkItem>();
+    item->work = std::move(work);
+    item->token = token;
+    item->counted = counted;
+    item->result = nullptr;
+    item->done.store(false);
+
+    enqueue(item);
+
+    sync_waiters_++;
+    auto done = [&] { return item->done.load(); };
+    if (!SpinUntil(done)) {
+        std::unique_lock<std::mutex> lock(item->mtx);
+        // The blocked caller doubles as the deadline watchdog: JS timers
+        // cannot fire while the V8 thread waits here.
+        if (token && token->deadline != CancelToken::Clock::time_point::max()) {
+            if (!item->cv.wait_until(lock, token->deadline, done)) {
+                token->cancel();
+            }
+        }
+        item->cv.wait(lock, done);
+    }
+    sync_waiters_--;
 
-    std::unique_lock<std::mutex> lock(item->mtx);
-    item->cv.wait(lock, [&] { return item->done; });
-    return item->result;
+    void* result = item->result;
+    item->token.reset();
+    if (pooled) sync_item_busy_.store(false);
+    return result;
 }
 
 void TeideThread::dispatch_async(std::function<void*()> work,
                                   Napi::ThreadSafeFunction tsfn,
-                                  std::function<void(Napi::Env, void*)> js_callback) {
+                                  std::function<void(Napi::Env, void*)> js_callback,
+                                  std::shared_ptr<CancelToken> token,
+                                  std::function<void()> on_skip) {
     auto cb = std::make_shared<std::function<void(Napi::Env, void*)>>(std::move(js_callback));
     auto item = std::make_shared<WorkItem>();
     item->work = std::move(work);
+    item->token = std::move(token);
+    item->on_skip = std::move(on_skip);
     item->on_done = [tsfn, cb](void* result) mutable {
         tsfn.BlockingCall(result, [cb](Napi::Env env, Napi::Function, void* data) {
             (*cb)(env, data);
@@ -75,16 +226,40 @@ void TeideThread::dispatch_async(std::function<void*()> work,
         tsfn.Release();
     };
 
-    {
-        std::lock_guard<std::mutex> lock(queue_mtx_);
-        queue_.push(item);
-    }
-    queue_cv_.notify_one();
+    enqueue(item);
 }
 
 void TeideThread::shutdown() {
     if (!running_.load()) return;
-    shutdown_ = true;
+    {
+        // Under the lock, or the store could land between the Teide
+        // thread's predicate check and its wait.
+        std::lock_guard<std::mutex> lock(queue_mtx_);
+        shutdown_ = true;
+    }
     queue_cv_.notify_one();
     if (thread_.joinable()) thread_.join();
 }
+
+QueueStats TeideThread::queue_stats() {
+    using ms = std::chrono::duration<double, std::milli>;
+    QueueStats st;
+    auto now = WorkItem::Clock::now();
+    std::lock_guard<std::mutex> lock(queue_mtx_);
+    st.depth = queue_.size();
+    st.queued_wait_ms.reserve(queue_.size());
+    for (const auto& item : queue_)
+        st.queued_wait_ms.push_back(ms(now - item->enqueued).count());
+    if (current_ && current_->counted) {
+        st.running = true;
+        st.running_wait_ms = ms(current_->started - current_->enqueued).count();
+        st.running_ms = ms(now - current_->started).count();
+    }
+    st.completed = completed_;
+    st.cancelled = cancelled_;
+    st.total_wait_ms = ms(total_wait_).count();
+    st.max_wait_ms = ms(max_wait_).count();
+    st.total_run_ms = ms(total_run_).count();
+    st.max_run_ms = ms(max_run_).count();
+    return st;
+}
@@ -6,43 +6,138 @@
 #include <thread>
 #include <mutex>
 #include <condition_variable>
-#include <queue>
+#include <deque>
+#include <vector>
 #include <functional>
 #include <atomic>
 #include <memory>
+#include <chrono>
+
+class ResultCache;
+
+// Forward-declare the engine's per-thread cancel flag (td.h, via compat.h).
+extern "C" { typedef struct td_cancel td_cancel_t; }
+
+// Cooperative cancellation handle shared by JS (via NativeCancelToken) and
+// the Teide thread. Queued items whose token is cancelled or past its
+// deadline are skipped; a running item is interrupted through td_cancel()
+// on the flag of the Teide thread running it.
+struct CancelToken {
+    using Clock = std::chrono::steady_clock;
+
+    std::atomic<bool> cancelled{false};
+    std::atomic<bool> running{false};
+    // Set before `running`, by the Teide thread that runs the item.
+    td_cancel_t* target = nullptr;
+    Clock::time_point deadline = Clock::time_point::max();
+
+    void cancel();
+    bool expired() const {
+        return cancelled.load() || Clock::now() >= deadline;
+    }
+};
 
 struct WorkItem {
+    using Clock = std::chrono::steady_clock;
+
     std::function<void*()> work;
     std::function<void(void*)> on_done;
+    // Runs on the Teide thread instead of `work` when the item is skipped
+    // (cancelled before it started), to drop references `work` would own.
+    std::function<void()> on_skip;
+    std::shared_ptr<CancelToken> token;
+    // False for bookkeeping probes, which stay out of the queue counters.
+    bool counted = true;
+    Clock::time_point enqueued;
+    Clock::time_point started;
     void* result = nullptr;
+    // Set under `mtx` so a parked waiter cannot miss it; a spinning waiter
+    // reads it without the lock.
     std::mutex mtx;
     std::condition_variable cv;
-    bool done = false;
+    std::atomic<bool> done{false};
+};
+
+// Snapshot of the work queue, taken under the queue lock without waiting
+// for the Teide thread. Times are in milliseconds.
+struct QueueStats {
+    size_t depth = 0;                    // items waiting, not counting the running one
+    std::vector<double> queued_wait_ms;  // per waiting item, oldest first
+    bool running = false;
+    double running_wait_ms = 0;          // how long the running item was queued
+    double running_ms = 0;               // how long it has been running
+    uint64_t completed = 0;              // items finished, including cancelled ones
+    uint64_t cancelled = 0;
+    double total_wait_ms = 0;
+    double max_wait_ms = 0;
+    double total_run_ms = 0;
+    double max_run_ms = 0;
 };
 
 class TeideThread {
 public:
     TeideThread();
     ~TeideThread();
-    void* dispatch_sync(std::function<void*()> work);
+    // Work results are td_t* (or TD_ERR_PTR). When `token` is cancelled or
+    // its deadline passes, the result is TD_ERR_PTR(TD_ERR_CANCEL) and any
+    // table the work produced is released.
+    void* dispatch_sync(std::function<void*()> work,
+                        std::shared_ptr<CancelToken> token = nullptr);
+    // dispatch_sync() for bookkeeping work such as the stats() snapshot:
+    // not counted in completed/wait/run, so polling does not skew them.
+    void* dispatch_probe(std::function<void*()> work);
     void dispatch_async(std::function<void*()> work,
                         Napi::ThreadSafeFunction tsfn,
-                        std::function<void(Napi::Env, void*)> js_callback);
+                        std::function<void(Napi::Env, void*)> js_callback,
+                        std::shared_ptr<CancelToken> token = nullptr,
+                        std::function<void()> on_skip = nullptr);
     void shutdown();
     bool is_running() const { return running_.load(); }
+    // True while the JS thread is blocked in dispatch_sync(). Work that
+    // waits on JS (streamed writes) must not block then.
+    bool sync_waiting() const { return sync_waiters_.load() > 0; }
+    QueueStats queue_stats();
 
     // Shared flag: true while the Teide heap is alive.
     // Handed to NativeTable/NativeSeries so they can skip td_release
     // during GC if the heap was already torn down.
     std::shared_ptr<std::atomic<bool>> heap_alive() const { return heap_alive_; }
 
+    // Result cache of the owning context, or null. Its entries live in this
+    // thread's heap, so the thread clears it before tearing the heap down.
+    // Set once, before any query is dispatched.
+    void set_result_cache(ResultCache* cache) { cache_ = cache; }
+    ResultCache* result_cache() const { return cache_; }
+
 private:
     void thread_main();
+    void run_item(WorkItem& item);
+    void enqueue(std::shared_ptr<WorkItem> item);
+    void* run_sync(std::function<void*()> work,
+                   std::shared_ptr<CancelToken> token, bool counted);
     std::thread thread_;
     std::atomic<bool> running_{false};
     std::atomic<bool> shutdown_{false};
+    std::atomic<int> sync_waiters_{0};
     std::mutex queue_mtx_;
     std::condition_variable queue_cv_;
-    std::queue<std::shared_ptr<WorkItem>> queue_;
+    std::deque<std::shared_ptr<WorkItem>> queue_;
+    // queue_.size(), readable without the lock by the spinning Teide thread.
+    std::atomic<size_t> queued_{0};
+    // dispatch_sync() reuses one item; a nested or concurrent call that
+    // finds it taken allocates its own.
+    std::shared_ptr<WorkItem> sync_item_ = std::make_shared<WorkItem>();
+    std::atomic<bool> sync_item_busy_{false};
+    // Guarded by queue_mtx_
+    bool parked_ = false;   // Teide thread is blocked on queue_cv_
+    std::shared_ptr<WorkItem> current_;
+    uint64_t completed_ = 0;
+    uint64_t cancelled_ = 0;
+    WorkItem::Clock::duration total_wait_{};
+    WorkItem::Clock::duration max_wait_{};
+    WorkItem::Clock::duration total_run_{};
+    WorkItem::Clock::duration max_run_{};
     std::shared_ptr<std::atomic<bool>> heap_alive_ = std::make_shared<std::atomic<bool>>(true);
+    ResultCache* cache_ = nullptr;
+    td_cancel_t* cancel_ = nullptr;  // this thread's engine cancel flag
 };
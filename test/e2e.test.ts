@@ -1,9 +1,14 @@
 import { describe, it, expect } from 'vitest';
+import fs from 'fs';
+import os from 'os';
 import path from 'path';
-import { Context, col } from '../lib';
+import { PassThrough, Writable } from 'stream';
+import { Worker } from 'worker_threads';
+import { Context, Table, col, ifElse, timeBucket, unpublish } from '../lib';
 
 const SMALL = path.join(__dirname, 'fixtures', 'small.csv');
 const SALES = path.join(__dirname, 'fixtures', 'sales.csv');
+const TICKS = path.join(__dirname, 'fixtures', 'ticks.csv');
 
 describe('End-to-end integration', () => {
   it('filter + collectSync', () => {
@@ -32,6 +37,24 @@ describe('End-to-end integration', () => {
     }
   });
 
+  it('back-to-back sync queries run in order with queued async ones', async () => {
+    const ctx = new Context();
+    try {
+      const df = ctx.readCsvSync(SALES);
+      const pending = [df.filter(col('price').gt(40)).collect(), df.sort('price').head(2).collect()];
+      for (let i = 0; i < 2000; i++) {
+        const q = df.filter(col('quantity').gt(i % 300)).groupBy('category').agg(col('price').sum());
+        expect(q.collectSync({ cache: false }).nRows).toBeLessThanOrEqual(3);
+      }
+      const [filtered, top] = await Promise.all(pending);
+      expect(filtered.nRows).toBe(5);
+      expect(top.nRows).toBe(2);
+      expect(ctx.stats().queue.completed).toBeGreaterThanOrEqual(2002);
+    } finally {
+      ctx.destroy();
+    }
+  });
+
   it('symbol column access', () => {
     const ctx = new Context();
     try {
@@ -48,6 +71,26 @@ describe('End-to-end integration', () => {
     }
   });
 
+  it('symbol dictionary is local to the column', () => {
+    const ctx = new Context();
+    try {
+      const df = ctx.readCsvSync(SALES);
+      const category = df.col('category');
+      const { indices, dictionary } = category;
+      expect(dictionary.length).toBe(new Set(dictionary).size);
+      expect(Math.max(...indices)).toBe(dictionary.length - 1);
+
+      const { bytes, offsets } = category.dictionaryBuffer;
+      expect(offsets.length).toBe(dictionary.length + 1);
+      const decoded = Array.from({ length: dictionary.length }, (_, i) =>
+        Buffer.from(bytes.subarray(offsets[i], offsets[i + 1])).toString('utf8'));
+      expect(decoded).toEqual(dictionary);
+      expect(category.dictionary).toBe(dictionary);
+    } finally {
+      ctx.destroy();
+    }
+  });
+
   it('head', () => {
     const ctx = new Context();
     try {
@@ -95,4 +138,726 @@ describe('End-to-end integration', () => {
       ctx.destroy();
     }
   });
+
+  it('collect rejects with the abort reason when signal already aborted', async () => {
+    const ctx = new Context();
+    try {
+      const df = ctx.readCsvSync(SALES);
+      const ac = new AbortController();
+      ac.abort(new Error('stop'));
+      await expect(df.sort('price').collect({ signal: ac.signal }))
+        .rejects.toThrow('stop');
+    } finally {
+      ctx.destroy();
+    }
+  });
+
+  it('collect with a live signal completes normally', async () => {
+    const ctx = new Context();
+    try {
+      const df = ctx.readCsvSync(SALES);
+      const ac = new AbortController();
+      const result = await df.filter(col('price').gt(100)).collect({ signal: ac.signal });
+      expect(result.nRows).toBeGreaterThan(0);
+    } finally {
+      ctx.destroy();
+    }
+  });
+
+  it('expired deadline skips the work', async () => {
+    const ctx = new Context();
+    try {
+      const df = ctx.readCsvSync(SALES);
+      expect(() => df.sort('price').collectSync({ timeoutMs: 0 }))
+        .toThrow(/timed out/);
+      await expect(ctx.readCsv(SALES, { timeoutMs: 0 }))
+        .rejects.toThrow(/timed out/);
+      // The context stays usable after a cancelled item.
+      expect(df.sort('price').collectSync().nRows).toBe(9);
+    } finally {
+      ctx.destroy();
+    }
+  });
+
+  it('explain shows the optimized plan without running it', () => {
+    const ctx = new Context();
+    try {
+      const df = ctx.readCsvSync(SALES);
+      const plan = df.filter(col('price').gt(100)).sort('price').explain();
+      expect(plan).toMatch(/SORT/);
+      expect(plan).toMatch(/SCAN price/);
+      expect(plan).not.toMatch(/^total/);
+    } finally {
+      ctx.destroy();
+    }
+  });
+
+  it('repeated subexpressions are evaluated once', () => {
+    const ctx = new Context();
+    try {
+      const df = ctx.readCsvSync(SALES);
+      const revenue = () => col('price').mul(col('quantity'));
+      const q = df.groupBy('category').agg(revenue().sum(), revenue().max());
+      expect(q.explain()).toMatch(/MUL -> \w+ \(shared\)/);
+      const result = q.collectSync();
+      const sums = Array.from(result.col(result.columns[1]).data, Number).sort((a, b) => a - b);
+      const maxes = Array.from(result.col(result.columns[2]).data, Number).sort((a, b) => a - b);
+      [2505.3, 10597.8, 34249.5].forEach((v, i) => expect(sums[i]).toBeCloseTo(v, 6));
+      [958.8, 3999.2, 17499.75].forEach((v, i) => expect(maxes[i]).toBeCloseTo(v, 6));
+    } finally {
+      ctx.destroy();
+    }
+  });
+
+  it('profile records rows and timings per node', () => {
+    const ctx = new Context();
+    try {
+      const df = ctx.readCsvSync(SALES);
+      const result = df.sort('price').collectSync({ profile: true });
+      const root = result.profile!.root!;
+      expect(root.op).toBe('SORT');
+      expect(root.rowsOut).toBe(9);
+      expect(root.timeMs).toBeGreaterThanOrEqual(root.selfTimeMs!);
+      expect(df.sort('price').collectSync().profile).toBeUndefined();
+      expect(df.sort('price').explain({ analyze: true })).toMatch(/rows=9->9/);
+    } finally {
+      ctx.destroy();
+    }
+  });
+
+  it('filter then sort gathers the surviving rows once', () => {
+    const ctx = new Context();
+    try {
+      const df = ctx.readCsvSync(SALES);
+      const sorted = df.filter(col('price').gt(40)).sort('quantity').collectSync({ profile: true });
+      expect(sorted.profile!.root!.paths).toContain('late-materialization');
+      expect(Array.from(sorted.col('quantity').data, Number)).toEqual([10, 15, 25, 40, 80]);
+      expect(Array.from(sorted.col('price').data)).toEqual([999.99, 449.99, 699.99, 89.99, 49.99]);
+      const top = df.filter(col('price').gt(40)).sort('quantity', { descending: true }).head(2)
+        .collectSync();
+      expect(Array.from(top.col('quantity').data, Number)).toEqual([80, 40]);
+    } finally {
+      ctx.destroy();
+    }
+  });
+
+  it('filter before groupBy only aggregates matching rows', () => {
+    const ctx = new Context();
+    try {
+      const df = ctx.readCsvSync(SALES);
+      const result = df.filter(col('price').gt(40))
+        .groupBy('category')
+        .agg(col('quantity').sum())
+        .collectSync();
+      expect(result.nRows).toBe(2);
+      const sums = Array.from(result.col(result.columns[1]).data, Number).sort((a, b) => a - b);
+      expect(sums).toEqual([50, 120]);
+    } finally {
+      ctx.destroy();
+    }
+  });
+
+  it('filter then groupBy can be sorted and limited', () => {
+    const ctx = new Context();
+    try {
+      const df = ctx.readCsvSync(SALES);
+      const grouped = () => df.filter(col('price').gt(40)).groupBy('category').agg(col('quantity').sum());
+      const sorted = grouped().sort('category').collectSync();
+      expect(sorted.nRows).toBe(2);
+      expect(Array.from(sorted.col(sorted.columns[1]).data, Number)).toEqual([120, 50]);
+      const top = grouped().sort('category', { descending: true }).head(1).collectSync();
+      expect(top.nRows).toBe(1);
+      expect(Array.from(top.col(top.columns[1]).data, Number)).toEqual([50]);
+      const limited = grouped().head(5).collectSync();
+      expect(limited.nRows).toBe(2);
+    } finally {
+      ctx.destroy();
+    }
+  });
+
+  it('groupBy computes exact and approximate quantiles', () => {
+    const ctx = new Context();
+    try {
+      const df = ctx.readCsvSync(SALES);
+      const result = df.groupBy('category')
+        .agg(col('quantity').median(), col('quantity').quantile(0.9), col('price').median({ approximate: true }))
+        .sort('category')
+        .collectSync();
+      expect(result.columns).toEqual(['category', 'quantity_median', 'quantity_p90', 'price_median']);
+      expect(Array.from(result.col('quantity_median').data)).toEqual([80, 15, 150]);
+      const p90 = Array.from(result.col('quantity_p90').data, Number);
+      [96, 23, 190].forEach((v, i) => expect(p90[i]).toBeCloseTo(v, 9));
+      const approx = Array.from(result.col('price_median').data, Number);
+      expect(approx[0]).toBeGreaterThanOrEqual(29.99);
+      expect(approx[0]).toBeLessThanOrEqual(89.99);
+
+      const filtered = df.filter(col('quantity').lt(100)).groupBy('category')
+        .agg(col('quantity').median()).sort('category').collectSync();
+      expect(Array.from(filtered.col('quantity_median').data)).toEqual([60, 15]);
+    } finally {
+      ctx.destroy();
+    }
+  });
+
+  it('quantiles reduce whole columns in select and filter', () => {
+    const ctx = new Context();
+    try {
+      const df = ctx.readCsvSync(SALES);
+      const m = df.select(col('quantity').median().alias('m'), col('quantity').quantile(0.9).alias('p90'))
+        .head(1).collectSync();
+      expect(m.col('m').data[0]).toBe(80);
+      expect(m.col('p90').data[0]).toBeCloseTo(160, 9);
+      const above = df.filter(col('quantity').gt(col('quantity').median())).sort('quantity').collectSync();
+      expect(Array.from(above.col('quantity').data, Number)).toEqual([100, 120, 150, 200]);
+      const approx = df.select(col('quantity').median({ approximate: true }).alias('m')).head(1).collectSync();
+      expect(approx.col('m').data[0]).toBe(80);
+    } finally {
+      ctx.destroy();
+    }
+  });
+
+  it('collectMany matches collecting each query alone', async () => {
+    const ctx = new Context();
+    try {
+      const df = ctx.readCsvSync(SALES);
+      const queries = () => [
+        df.filter(col('price').gt(40)).groupBy('category').agg(col('quantity').sum()),
+        df.filter(col('price').gt(40)).groupBy('category')
+          .agg(col('price').mul(col('quantity')).sum(), col('quantity').sum()).sort('category'),
+        df.filter(col('price').gt(40)).select('product'),
+        df.groupBy('category').agg(col('price').max()),
+        df.sort('price').head(2),
+      ];
+      const alone = queries().map((q) => q.collectSync({ cache: false }));
+      const batched = await ctx.collectMany(queries());
+      const batchedSync = ctx.collectManySync(queries());
+      expect(batched).toHaveLength(alone.length);
+      for (const results of [batched, batchedSync]) {
+        results.forEach((t, i) => {
+          expect(t.columns).toEqual(alone[i].columns);
+          for (const name of t.columns) {
+            expect(Array.from(t.col(name).data)).toEqual(Array.from(alone[i].col(name).data));
+          }
+        });
+      }
+      expect(batched[1].columns).toEqual(['category', '_e0_sum', 'quantity_sum']);
+      expect(await ctx.collectMany([])).toEqual([]);
+    } finally {
+      ctx.destroy();
+    }
+  });
+
+  it('collectMany splits shared group-bys above 8 aggregates', async () => {
+    const ctx = new Context();
+    try {
+      const df = ctx.readCsvSync(SALES);
+      // 13 distinct aggregates over one key: more than one td_group holds
+      const queries = () => [
+        df.groupBy('category').agg(col('price').sum(), col('price').min(), col('price').max(),
+          col('price').mean(), col('price').first(), col('price').last()).sort('category'),
+        df.groupBy('category').agg(col('quantity').sum(), col('quantity').min(), col('quantity').max(),
+          col('quantity').mean(), col('quantity').first(), col('quantity').last()).sort('category'),
+        df.groupBy('category').agg(col('price').sum(), col('quantity').count()).sort('category'),
+      ];
+      const alone = queries().map((q) => q.collectSync({ cache: false }));
+      for (const results of [await ctx.collectMany(queries()), ctx.collectManySync(queries())]) {
+        expect(results).toHaveLength(alone.length);
+        results.forEach((t, i) => {
+          expect(t.columns).toEqual(alone[i].columns);
+          for (const name of t.columns) {
+            expect(Array.from(t.col(name).data)).toEqual(Array.from(alone[i].col(name).data));
+          }
+        });
+      }
+    } finally {
+      ctx.destroy();
+    }
+  });
+
+  it('select computes columns natively', () => {
+    const ctx = new Context();
+    try {
+      const df = ctx.readCsvSync(SALES);
+      const result = df.filter(col('category').eq('electronics'))
+        .select('product', col('price').mul(col('quantity')).alias('revenue'))
+        .sort('revenue', { descending: true })
+        .collectSync();
+      expect(result.columns).toEqual(['product', 'revenue']);
+      const revenue = result.col('revenue').data;
+      expect(revenue[0]).toBeCloseTo(699.99 * 25);
+      expect(revenue[1]).toBeCloseTo(999.99 * 10);
+    } finally {
+      ctx.destroy();
+    }
+  });
+
+  it('withColumns replaces and appends columns', () => {
+    const ctx = new Context();
+    try {
+      const df = ctx.readCsvSync(SMALL);
+      const result = df.withColumns(
+        col('value').mul(2).alias('value'),
+        col('name').upper().alias('shout'),
+        ifElse(col('id').gt(1), 1, 0).alias('later'),
+      ).collectSync();
+      expect(result.columns).toEqual(['id', 'name', 'value', 'shout', 'later']);
+      expect(result.col('value').data[0]).toBeCloseTo(21);
+      const shout = result.col('shout');
+      expect(Array.from(shout.indices, (i) => shout.dictionary[i])).toEqual(['ALPHA', 'BETA', 'GAMMA']);
+      expect(Array.from(result.col('later').data, Number)).toEqual([0, 1, 1]);
+    } finally {
+      ctx.destroy();
+    }
+  });
+
+  it('select and withColumns reject more than 255 columns', () => {
+    const ctx = new Context();
+    try {
+      const df = ctx.readCsvSync(SMALL);
+      const many = Array.from({ length: 256 }, (_, i) => col('value').add(i).alias(`v${i}`));
+      expect(df.select(...many.slice(0, 255)).collectSync().columns.length).toBe(255);
+      expect(() => df.select(...many).collectSync()).toThrow('range error');
+      expect(() => df.withColumns(...many).collectSync()).toThrow('range error');
+    } finally {
+      ctx.destroy();
+    }
+  });
+
+  it('isIn filters on symbol and numeric lists', () => {
+    const ctx = new Context();
+    try {
+      const df = ctx.readCsvSync(SALES);
+      expect(df.filter(col('category').isIn(['food', 'clothing'])).collectSync().nRows).toBe(6);
+      expect(df.filter(col('category').isIn(['food', 'nope'])).collectSync().nRows).toBe(3);
+      expect(df.filter(col('category').isIn([])).collectSync().nRows).toBe(0);
+      const qty = df.filter(col('quantity').isIn([10, 25, 200, 7])).collectSync();
+      expect(Array.from(qty.col('quantity').data, Number)).toEqual([10, 25, 200]);
+      expect(df.filter(col('price').isIn([3.99, 49.99])).collectSync().nRows).toBe(2);
+    } finally {
+      ctx.destroy();
+    }
+  });
+
+  it('groupBy on a time bucket folds the bucket into the group key', () => {
+    const ctx = new Context();
+    try {
+      const df = ctx.readCsvSync(TICKS);
+      const ts = Array.from(df.col('ts').data as BigInt64Array, Number);
+      const size = Array.from(df.col('size').data, Number);
+      const ref = new Map<number, number>();
+      ts.forEach((t, i) => {
+        const b = Math.floor(t / 1000) * 1000;
+        ref.set(b, (ref.get(b) ?? 0) + size[i]);
+      });
+      const result = df.groupBy(timeBucket('ts', 1000)).agg(col('size').sum())
+        .sort('ts').collectSync();
+      expect(Array.from(result.col('ts').data as BigInt64Array, Number)).toEqual([...ref.keys()].sort((a, b) => a - b));
+      expect(Array.from(result.col('size_sum').data, Number))
+        .toEqual([...ref.entries()].sort((a, b) => a[0] - b[0]).map((e) => e[1]));
+
+      const q = df.groupBy(timeBucket('ts', 60000, 30000).alias('minute')).agg(col('size').count());
+      expect(q.explain()).toMatch(/TIME_BUCKET width=60000 origin=30000/);
+      const minutes = q.collectSync();
+      expect(minutes.columns).toContain('minute');
+      expect(Array.from(minutes.col('size_count').data, Number).sort()).toEqual([1, 10]);
+
+      expect(() => df.groupBy(col('ts').add(1)).agg(col('size').sum())).toThrow('alias');
+      expect(() => df.groupBy(timeBucket('ts', 1000)).materialize(col('size').sum())).toThrow('materialize');
+    } finally {
+      ctx.destroy();
+    }
+  });
+
+  it('groupBy on a sorted key streams runs in key order', () => {
+    const ctx = new Context();
+    try {
+      const df = ctx.readCsvSync(TICKS);
+      const result = df.groupBy('ts').agg(col('size').sum(), col('price').max())
+        .collectSync({ profile: true });
+      expect(result.profile!.root!.paths).toContain('merge');
+      expect(Array.from(result.col('size_sum').data, Number)).toEqual([150, 25, 80, 70, 100, 5]);
+      expect(Array.from(result.col('price_max').data)).toEqual([10.75, 10.5, 11.25, 10.25, 10.5, 12]);
+      const filtered = df.filter(col('size').gt(30)).groupBy('ts').agg(col('size').sum()).collectSync();
+      expect(Array.from(filtered.col('size_sum').data, Number)).toEqual([150, 40, 70, 80]);
+    } finally {
+      ctx.destroy();
+    }
+  });
+
+  it('groupBy on skewed and high-cardinality keys matches a reference', () => {
+    const ctx = new Context();
+    const dir = fs.mkdtempSync(path.join(os.tmpdir(), 'teide-grp-'));
+    try {
+      const n = 200000;
+      const rows: string[] = [];
+      for (let i = 0; i < n; i++) {
+        const k = i % 3 === 0 ? 7 : (i * 7919) % 60000;
+        rows.push(`${k},${i % 101}`);
+      }
+      const file = path.join(dir, 'skew.csv');
+      fs.writeFileSync(file, ['k,v', ...rows].join('\n') + '\n');
+
+      const df = ctx.readCsvSync(file);
+      for (const min of [-1, 50]) {
+        const want = new Map<number, [number, number]>();
+        for (const r of rows) {
+          const [k, v] = r.split(',').map(Number);
+          if (v <= min) continue;
+          const acc = want.get(k) ?? [0, 0];
+          acc[0] += 1;
+          acc[1] += v;
+          want.set(k, acc);
+        }
+        const result = df.filter(col('v').gt(min)).groupBy('k')
+          .agg(col('v').count(), col('v').sum()).sort('k').collectSync();
+        const keys = [...want.keys()].sort((a, b) => a - b);
+        expect(result.nRows).toBe(keys.length);
+        expect(Array.from(result.col('k').data, Number)).toEqual(keys);
+        expect(Array.from(result.col('v_count').data, Number)).toEqual(keys.map((k) => want.get(k)![0]));
+        expect(Array.from(result.col('v_sum').data, Number)).toEqual(keys.map((k) => want.get(k)![1]));
+      }
+    } finally {
+      ctx.destroy();
+      fs.rmSync(dir, { recursive: true, force: true });
+    }
+  });
+
+  it('append grows the table and later queries see the new rows', () => {
+    const ctx = new Context();
+    try {
+      const df = ctx.readCsvSync(SALES);
+      const before = df.filter(col('price').gt(40)).collectSync();
+      df.append(ctx.readCsvSync(SALES)).append(ctx.readCsvSync(SALES));
+      expect(df.nRows).toBe(27);
+      expect(before.nRows).toBe(5);
+      expect(df.filter(col('price').gt(40)).collectSync().nRows).toBe(15);
+      expect(() => df.append(ctx.readCsvSync(SMALL))).toThrow('append');
+      expect(df.nRows).toBe(27);
+    } finally {
+      ctx.destroy();
+    }
+  });
+
+  it('published tables open in other contexts and outlive their publisher', () => {
+    const a = new Context();
+    const b = new Context();
+    try {
+      const df = a.readCsvSync(SALES);
+      const want = df.groupBy('category').agg(col('price').sum()).sort('category').collectSync();
+      const handle = df.publish();
+      df.append(a.readCsvSync(SALES));  // the snapshot does not see it
+      a.destroy();
+
+      const shared = b.openShared(handle);
+      expect(shared.nRows).toBe(9);
+      const got = shared.groupBy('category').agg(col('price').sum()).sort('category').collectSync();
+      expect(got.col('category').dictionary).toEqual(want.col('category').dictionary);
+      expect(Array.from(got.col('price_sum').data)).toEqual(Array.from(want.col('price_sum').data));
+      expect(() => shared.append(b.readCsvSync(SALES))).toThrow('read-only');
+
+      expect(unpublish(handle)).toBe(true);
+      expect(unpublish(handle)).toBe(false);
+      expect(() => b.openShared(handle)).toThrow('Unknown shared table handle');
+      expect(shared.filter(col('price').gt(40)).collectSync().nRows).toBe(5);
+    } finally {
+      a.destroy();
+      b.destroy();
+    }
+  });
+
+  it('published tables keep their symbols with no context alive', () => {
+    const a = new Context();
+    const df = a.readCsvSync(SALES);
+    const handle = df.publish();
+    const want = Array.from(df.col('product').indices, (i) => df.col('product').dictionary[i]);
+    a.destroy();
+
+    // Interning other strings first would reuse the ids of a reset table
+    const b = new Context();
+    try {
+      expect(b.readCsvSync(SMALL).nRows).toBe(3);
+      const shared = b.openShared(handle);
+      const product = shared.col('product');
+      expect(Array.from(product.indices, (i) => product.dictionary[i])).toEqual(want);
+      expect(shared.filter(col('category').eq('food')).collectSync().nRows).toBe(3);
+    } finally {
+      unpublish(handle);
+      b.destroy();
+    }
+  });
+
+  it('worker threads open a published table by handle', async () => {
+    const ctx = new Context();
+    try {
+      const handle = ctx.readCsvSync(SALES).publish();
+      const addonPath = path.join(__dirname, '..', 'build', 'Release', 'teidedb_addon.node');
+      const worker = new Worker(`
+        const { parentPort, workerData } = require('worker_threads');
+        const addon = require(workerData.addonPath);
+        const ctx = new addon.NativeContext();
+        const t = ctx.openShared(workerData.handle);
+        parentPort.postMessage([t.nRows, t.columns]);
+        ctx.destroy();
+      `, { eval: true, workerData: { handle, addonPath } });
+      const [nRows, columns] = await new Promise<[number, string[]]>((resolve, reject) => {
+        worker.once('message', resolve);
+        worker.once('error', reject);
+      });
+      await worker.terminate();
+      expect(nRows).toBe(9);
+      expect(columns).toEqual(ctx.readCsvSync(SALES).columns);
+      unpublish(handle);
+    } finally {
+      ctx.destroy();
+    }
+  });
+
+  it('materialized groupBy tracks appends', () => {
+    const ctx = new Context();
+    try {
+      const df = ctx.readCsvSync(SALES);
+      const aggs = () => [col('quantity').sum(), col('price').mean(), col('quantity').max()];
+      const view = df.groupBy('category').materialize(...aggs());
+      // One "category: values" line per group, sorted
+      const rows = (t: Table) => {
+        const cat = t.col('category');
+        return Array.from(cat.indices, (code, i) => cat.dictionary[code] + ': ' +
+          t.columns.slice(1).map((c) => Number(t.col(c).data[i]).toFixed(6)).join(' ')).sort();
+      };
+      for (let i = 0; i < 3; i++) {
+        df.append(ctx.readCsvSync(SALES));
+        const got = view.collectSync();
+        const want = df.groupBy('category').agg(...aggs()).collectSync();
+        expect(got.columns).toEqual(want.columns);
+        expect(rows(got)).toEqual(rows(want));
+      }
+      expect(view.collectSync().col('quantity_sum').data).toHaveLength(3);
+      view.drop();
+      expect(() => view.collectSync()).toThrow('dropped');
+      expect(() => df.groupBy('category').materialize(col('price').add(1).sum())).toThrow('materialize');
+    } finally {
+      ctx.destroy();
+    }
+  });
+
+  it('stats reports heap, symbols and queue activity', async () => {
+    const ctx = new Context();
+    try {
+      const df = await ctx.readCsv(SALES);
+      await df.sort('price').collect();
+      const stats = ctx.stats();
+      expect(stats.queue.depth).toBe(0);
+      expect(stats.queue.running).toBeNull();
+      expect(stats.queue.completed).toBeGreaterThanOrEqual(2);
+      expect(stats.heap!.poolBytes).toBeGreaterThan(0);
+      expect(stats.heap!.inUseBytes).toBeLessThanOrEqual(stats.heap!.poolBytes);
+      expect(stats.symbols!.count).toBeGreaterThan(0);
+      expect(stats.pool!.utilization).toBeLessThanOrEqual(1);
+      expect(stats.engineAgeMs).toBeLessThan(1000);
+      // The snapshot probes themselves are not counted as queue work
+      for (let i = 0; i < 5; i++) ctx.stats();
+      expect(ctx.stats().queue.completed).toBe(stats.queue.completed);
+    } finally {
+      ctx.destroy();
+    }
+    expect(() => ctx.stats()).toThrow('destroyed');
+  });
+
+  it('result cache serves repeated queries until the table changes', async () => {
+    const ctx = new Context({ resultCacheBytes: 1 << 20 });
+    try {
+      const df = ctx.readCsvSync(SALES);
+      const q = () => df.filter(col('price').gt(40)).filter(col('quantity').lt(50)).sort('quantity');
+      const first = q().collectSync();
+      const n = first.nRows;
+      expect(ctx.stats().cache!.entries).toBe(1);
+
+      // Adjacent filters commute, so the reordered query hits too.
+      const again = await df.filter(col('quantity').lt(50)).filter(col('price').gt(40))
+        .sort('quantity').collect();
+      expect(again.col('quantity').data).toEqual(first.col('quantity').data);
+      expect(ctx.stats().cache!.hits).toBe(1);
+
+      q().collectSync({ cache: false });
+      q().collectSync({ profile: true });
+      expect(ctx.stats().cache!.hits).toBe(1);
+
+      df.append(ctx.readCsvSync(SALES));
+      expect(ctx.stats().cache!.entries).toBe(0);
+      expect(q().collectSync().nRows).toBe(2 * n);
+      expect(first.nRows).toBe(n);
+    } finally {
+      ctx.destroy();
+    }
+    expect(() => new Context({ resultCacheBytes: -1 })).toThrow('resultCacheBytes');
+  });
+
+  it('result cache keeps column data private to each caller', () => {
+    const ctx = new Context({ resultCacheBytes: 1 << 20 });
+    try {
+      const df = ctx.readCsvSync(SALES);
+      const q = () => df.filter(col('quantity').gt(20)).sort('price');
+      const a = q().collectSync();
+      const mine = a.col('price').data as Float64Array;
+      const price = Array.from(mine);
+      mine[0] = -1;
+
+      const b = q().collectSync();
+      expect(ctx.stats().cache!.hits).toBe(1);
+      expect(Array.from(b.col('price').data as Float64Array)).toEqual(price);
+
+      // A source viewed in place may change under the cache: not cached from
+      const src = df.col('price').data as Float64Array;
+      src[0] += 1;
+      const before = ctx.stats().cache!;
+      expect(q().collectSync().nRows).toBe(a.nRows);
+      expect(ctx.stats().cache!.hits).toBe(before.hits);
+      expect(ctx.stats().cache!.misses).toBe(before.misses);
+    } finally {
+      ctx.destroy();
+    }
+  });
+
+  it('huge pages, prefaulting and a warm reserve leave results unchanged', () => {
+    // Columns of 4.8 MB: above the 2 MB blocks that prefaulting and huge
+    // pages apply to. Engine-level effects are covered by the native
+    // heap_policy test; this checks results through the page policy.
+    const dir = fs.mkdtempSync(path.join(os.tmpdir(), 'teide-heap-'));
+    const file = path.join(dir, 'big.csv');
+    const lines = ['k,v'];
+    for (let i = 0; i < 600000; i++) lines.push(`${(i * 7919) % 1000},${(i * 104729) % 100003}.5`);
+    fs.writeFileSync(file, lines.join('\n') + '\n');
+    const run = (c: Context) => {
+      const df = c.readCsvSync(file);
+      const sorted = df.sort('v', { descending: true }).collectSync();
+      const sums = df.groupBy('k').agg(col('v').sum()).sort('k').collectSync();
+      return [sorted.col('v').data, sorted.col('k').data, sums.col(sums.columns[1]).data];
+    };
+
+    // The policy is process-wide: the baseline runs before it is set
+    const reset = { hugePages: false, prefault: false, warmReserveBytes: 0 };
+    new Context(reset).destroy();
+    const base = new Context();
+    let expected;
+    try {
+      expected = run(base);
+    } finally {
+      base.destroy();
+    }
+
+    const ctx = new Context({ hugePages: true, prefault: true, warmReserveBytes: 256 << 20 });
+    try {
+      expect(run(ctx)).toEqual(expected);
+      expect(run(ctx)).toEqual(expected);   // again, from warm pools
+    } finally {
+      ctx.destroy();
+      new Context(reset).destroy();
+      fs.rmSync(dir, { recursive: true, force: true });
+    }
+    expect(() => new Context({ hugePages: 'yes' as any })).toThrow('hugePages');
+    expect(() => new Context({ warmReserveBytes: -1 })).toThrow('warmReserveBytes');
+  });
+
+  it('rejects invalid worker pool options', () => {
+    expect(() => new Context({ threads: 0 })).toThrow('threads');
+    expect(() => new Context({ threads: 1.5 })).toThrow('threads');
+    expect(() => new Context({ cpus: [-1] })).toThrow('cpus');
+    expect(() => new Context({ cpus: [65000] })).toThrow('not available');
+  });
+
+  it('writeCsv round-trips through readCsv', async () => {
+    const ctx = new Context();
+    const dir = fs.mkdtempSync(path.join(os.tmpdir(), 'teide-csv-'));
+    try {
+      const df = ctx.readCsvSync(SALES);
+      const file = path.join(dir, 'out.csv');
+      df.writeCsvSync(file);
+      expect(fs.readFileSync(file, 'utf8')).toBe(fs.readFileSync(SALES, 'utf8'));
+      const back = ctx.readCsvSync(file);
+      expect(back.columns).toEqual(df.columns);
+      expect(Array.from(back.col('price').data)).toEqual(Array.from(df.col('price').data));
+
+      await df.writeCsv(file, { delimiter: '|', header: false });
+      const lines = fs.readFileSync(file, 'utf8').trimEnd().split('\n');
+      expect(lines).toHaveLength(9);
+      expect(lines[0]).toBe('electronics|laptop|999.99|10');
+      expect(() => df.writeCsvSync(file, { delimiter: ',,' })).toThrow('delimiter');
+    } finally {
+      ctx.destroy();
+      fs.rmSync(dir, { recursive: true, force: true });
+    }
+  });
+
+  it('readCsv parses numbers, dates and timestamps exactly', () => {
+    const ctx = new Context();
+    const dir = fs.mkdtempSync(path.join(os.tmpdir(), 'teide-csv-'));
+    try {
+      const f64 = ['0.1', '2.2250738585072014e-308', '1.7976931348623157e308',
+                   '9007199254740993', '0.30000000000000004', '-123456.789e-40',
+                   '00012.50000000000000000000', '3.14159265358979323846264'];
+      const i64 = ['0', '-7', '+42', '123456789012345678', '-9223372036854775808',
+                   '1234567', '99999999', '100000000'];
+      const dates = ['1970-01-01', '2024-02-29', '1969-12-31', '2000-13-01',
+                     '1999-12-31', '2038-01-19', '1900-03-01', '2024-01-15'];
+      const ts = dates.map((d, i) => `${d}T12:34:56${i % 2 ? '.25' : ''}`);
+      const rows = f64.map((v, i) => [v, i64[i], dates[i], ts[i]].join(','));
+      const file = path.join(dir, 'types.csv');
+      fs.writeFileSync(file, ['f,i,d,ts', ...rows].join('\n') + '\n');
+
+      const df = ctx.readCsvSync(file);
+      expect(Array.from(df.col('f').data)).toEqual(f64.map(Number));
+      expect(Array.from(df.col('i').data)).toEqual(i64.map((v) => BigInt(v)));
+      const days = dates.map((d) => Date.UTC(+d.slice(0, 4), +d.slice(5, 7) - 1, +d.slice(8)) / 864e5);
+      days[3] = 0;  // month 13 is out of range
+      expect(Array.from(df.col('d').data)).toEqual(days);
+      const us = df.col('ts').data as BigInt64Array;
+      expect(us[0]).toBe(45296000000n);
+      expect(us[1]).toBe(BigInt(days[1]) * 86400000000n + 45296250000n);
+    } finally {
+      ctx.destroy();
+      fs.rmSync(dir, { recursive: true, force: true });
+    }
+  });
+
+  it('writeCsv streams chunks in row order', async () => {
+    const ctx = new Context();
+    try {
+      const df = ctx.readCsvSync(SALES);
+      const out = new PassThrough();
+      const chunks: Buffer[] = [];
+      out.on('data', (c: Buffer) => chunks.push(c));
+      await df.writeCsv(out);
+      expect(Buffer.concat(chunks).toString()).toBe(fs.readFileSync(SALES, 'utf8'));
+
+      const closed = new PassThrough();
+      closed.destroy();
+      await expect(df.writeCsv(closed)).rejects.toThrow();
+    } finally {
+      ctx.destroy();
+    }
+  });
+
+  it('a stalled CSV stream does not hold up other queries', async () => {
+    const ctx = new Context();
+    const dir = fs.mkdtempSync(path.join(os.tmpdir(), 'teide-csv-'));
+    try {
+      const file = path.join(dir, 'big.csv');
+      const rows = Array.from({ length: 600000 }, (_, i) => String(i));
+      fs.writeFileSync(file, ['v', ...rows].join('\n') + '\n');
+      const df = ctx.readCsvSync(file);
+
+      // Takes one chunk and never finishes writing it
+      const stalled = new Writable({ highWaterMark: 1, write() {} });
+      const ac = new AbortController();
+      const pending = df.writeCsv(stalled, { signal: ac.signal });
+      await new Promise((r) => setTimeout(r, 50));
+      expect(df.filter(col('v').lt(10)).collectSync().nRows).toBe(10);
+      expect((await df.filter(col('v').lt(5)).collect()).nRows).toBe(5);
+      ac.abort();
+      await expect(pending).rejects.toThrow();
+    } finally {
+      ctx.destroy();
+      fs.rmSync(dir, { recursive: true, force: true });
+    }
+  });
 });
@@ -1,5 +1,5 @@
 import { describe, it, expect } from 'vitest';
-import { col, lit, Expr } from '../lib/expr';
+import { col, lit, ifElse, concat, timeBucket, Expr } from '../lib/expr';
 
 describe('Expr tree', () => {
   it('builds column reference', () => {
@@ -26,6 +26,13 @@ describe('Expr tree', () => {
     expect(e.params.op).toBe(50); // OP_SUM
   });
 
+  it('builds quantile aggregations', () => {
+    expect(col('x').median().params).toMatchObject({ op: 77, q: 0.5 }); // OP_QUANTILE
+    expect(col('x').percentile(95, { approximate: true }).params).toMatchObject({ op: 78, q: 0.95 });
+    expect(() => col('x').quantile(1.5)).toThrow(TypeError);
+    expect(() => col('x').quantile(NaN)).toThrow(TypeError);
+  });
+
   it('builds chained expression', () => {
     const e = col('a').add(col('b')).mul(lit(2));
     expect(e.kind).toBe('binop');
@@ -51,4 +58,48 @@ describe('Expr tree', () => {
     expect(e.kind).toBe('unop');
     expect(e.params.op).toBe('neg');
   });
+
+  it('builds membership test', () => {
+    const e = col('category').isIn(['food', 'clothing']);
+    expect(e.kind).toBe('in');
+    expect((e.params.arg as Expr).params.name).toBe('category');
+    expect(e.params.values).toEqual(['food', 'clothing']);
+    expect(() => col('x').isIn([1, 'a'])).toThrow(TypeError);
+  });
+
+  it('builds function calls', () => {
+    const e = ifElse(col('x').gt(0), col('x'), 0);
+    expect(e.kind).toBe('call');
+    expect(e.params.fn).toBe('if');
+    expect((e.params.args as Expr[]).map((a) => a.kind)).toEqual(['binop', 'col', 'lit']);
+
+    const s = col('name').substr(1, 3);
+    expect(s.params.fn).toBe('substr');
+    expect((s.params.args as Expr[])[2].params.value).toBe(3);
+    expect(concat(col('a'), '-', col('b')).params.args).toHaveLength(3);
+    expect(() => concat(col('a'))).toThrow(TypeError);
+  });
+
+  it('encodes cast types and date fields as native codes', () => {
+    expect(col('x').cast('f64').params.opt).toBe(7);
+    expect(col('ts').extract('month').params.opt).toBe(1);
+    expect(col('ts').dateTrunc('hour').params.fn).toBe('date_trunc');
+    expect(() => col('x').cast('float')).toThrow(TypeError);
+    expect(() => col('ts').extract('week' as any)).toThrow(TypeError);
+  });
+
+  it('encodes time buckets as a width and unit', () => {
+    const b = col('ts').timeBucket('5m');
+    expect(b.params.fn).toBe('time_bucket');
+    expect(b.params.opt).toBe(1);
+    expect((b.params.args as Expr[])[1].params.value).toBe(300000000);
+    const q = timeBucket('ts', '1q', 2);
+    expect(q.params.opt).toBe(2);
+    expect((q.params.args as Expr[]).map((a) => a.params.value ?? a.params.name)).toEqual(['ts', 3, 2]);
+    expect(timeBucket(col('px'), 10).params.opt).toBe(0);
+    expect(() => timeBucket('ts', '5 min')).toThrow(TypeError);
+    expect(() => timeBucket('ts', 0)).toThrow(TypeError);
+    expect(() => timeBucket('ts', 1.5)).toThrow(TypeError);
+    expect(() => timeBucket('ts', '1h', 0.5)).toThrow(TypeError);
+  });
 });
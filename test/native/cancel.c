@@ -0,0 +1,125 @@
+/*
+ *   Copyright (c) 2024-2026 Anton Kundenko <singaraiona@gmail.com>
+ *   All rights reserved.
+
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy
+ *   of this software and associated documentation files (the "Software"), to deal
+ *   in the Software without restriction, including without limitation the rights
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *   copies of the Software, and to permit persons to whom the Software is
+ *   furnished to do so, subject to the following conditions:
+
+ *   The above copyright notice and this permission notice shall be included in all
+ *   copies or substantial portions of the Software.
+
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *   SOFTWARE.
+ */
+
+/*
+ * Cancellation is scoped to the query thread: cancelling one thread's
+ * query must not abort a query another thread runs on the shared pool.
+ */
+
+#include "check.h"
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define N_ROWS  (4 * 1000 * 1000)
+
+static td_cancel_t*     g_runner_cancel;
+static atomic_int       g_running;
+static atomic_int       g_started;
+static td_t*            g_result;
+
+static td_t* make_table(void) {
+    td_t* v = td_vec_new(TD_I64, N_ROWS);
+    v->len = N_ROWS;
+    uint64_t x = 88172645463325252ULL;
+    for (int64_t i = 0; i < N_ROWS; i++) {
+        x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+        ((int64_t*)td_data(v))[i] = (int64_t)(x >> 1);
+    }
+    td_t* t = td_table_new(1);
+    t = td_table_add_col(t, test_sym("v"), v);
+    td_release(v);
+    return t;
+}
+
+/* Sorts a large column on its own heap and reports whether it was complete */
+static void* runner(void* arg) {
+    (void)arg;
+    td_heap_init();
+    td_sym_init();
+    g_runner_cancel = td_cancel_self();
+    td_t* t = make_table();
+
+    atomic_store(&g_running, 1);
+    atomic_store(&g_started, 1);
+    td_graph_t* g = td_graph_new(t);
+    td_op_t* keys[1] = { td_scan(g, "v") };
+    uint8_t desc[1] = { 0 };
+    td_t* r = td_execute(g, td_sort_op(g, td_const_table(g, t), keys, desc, NULL, 1));
+    atomic_store(&g_running, 0);
+    td_graph_free(g);
+
+    if (!TD_IS_ERR(r)) {
+        td_t* c = td_table_get_col_idx(r, 0);
+        const int64_t* d = (const int64_t*)td_data(c);
+        bool sorted = c->len == N_ROWS;
+        for (int64_t i = 1; sorted && i < c->len; i++) sorted = d[i - 1] <= d[i];
+        td_release(r);
+        r = sorted ? NULL : TD_ERR_PTR(TD_ERR_NYI);
+    }
+    g_result = r;
+    td_release(t);
+    td_sym_destroy();
+    td_heap_destroy();
+    return NULL;
+}
+
+/* Runs the sort on another thread, raising `target` while it executes */
+static td_t* run_cancelling(td_cancel_t* target, bool runner_own) {
+    atomic_store(&g_started, 0);
+    atomic_store(&g_running, 0);
+    pthread_t th;
+    pthread_create(&th, NULL, runner, NULL);
+    while (!atomic_load(&g_started)) {}
+    while (atomic_load(&g_running))
+        td_cancel(runner_own ? g_runner_cancel : target);
+    pthread_join(th, NULL);
+    return g_result;
+}
+
+int main(void) {
+    td_heap_init();
+    td_sym_init();
+    td_pool_init(4);
+
+    /* Another query thread's flag: the runner must finish untouched */
+    td_t* r = run_cancelling(td_cancel_self(), false);
+    CHECK(r == NULL);
+
+    /* This thread's next query starts from a clear flag */
+    td_t* t = make_table();
+    td_graph_t* g = td_graph_new(t);
+    td_t* s = td_execute(g, td_sum(g, td_scan(g, "v")));
+    CHECK_OK(s);
+    if (s && !TD_IS_ERR(s)) td_release(s);
+    td_graph_free(g);
+    td_release(t);
+
+    /* The runner's own flag stops its query */
+    r = run_cancelling(NULL, true);
+    CHECK(TD_IS_ERR(r) && TD_ERR_CODE(r) == TD_ERR_CANCEL);
+
+    td_pool_destroy();
+    td_sym_destroy();
+    td_heap_destroy();
+    TEST_DONE();
+}
@@ -0,0 +1,64 @@
+/*
+ *   Copyright (c) 2024-2026 Anton Kundenko <singaraiona@gmail.com>
+ *   All rights reserved.
+
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy
+ *   of this software and associated documentation files (the "Software"), to deal
+ *   in the Software without restriction, including without limitation the rights
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *   copies of the Software, and to permit persons to whom the Software is
+ *   furnished to do so, subject to the following conditions:
+
+ *   The above copyright notice and this permission notice shall be included in all
+ *   copies or substantial portions of the Software.
+
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *   SOFTWARE.
+ */
+
+/*
+ * check.h -- assertions for the native engine tests.
+ *
+ * Each test binary keeps going after a failed CHECK, prints every failure
+ * with its location and exits non-zero if there was any, so ctest reports
+ * the whole picture of one run.
+ */
+
+#ifndef TD_TEST_CHECK_H
+#define TD_TEST_CHECK_H
+
+#include <teide/td.h>
+#include <stdio.h>
+#include <string.h>
+
+static int g_fails;
+
+#define CHECK(cond)                                                       \
+    do { if (!(cond)) {                                                   \
+             fprintf(stderr, "%s:%d: CHECK(%s) failed\n",                 \
+                     __FILE__, __LINE__, #cond);                          \
+             g_fails++;                                                   \
+         } } while (0)
+
+/* A result that must be a value, not an error */
+#define CHECK_OK(p)                                                       \
+    do { if (!(p) || TD_IS_ERR(p)) {                                      \
+             fprintf(stderr, "%s:%d: %s: %s\n", __FILE__, __LINE__, #p,   \
+                     (p) ? td_err_str(TD_ERR_CODE(p)) : "NULL");          \
+             g_fails++;                                                   \
+         } } while (0)
+
+#define TEST_DONE()                                                       \
+    do { if (g_fails) fprintf(stderr, "%d check(s) failed\n", g_fails);   \
+         return g_fails ? 1 : 0; } while (0)
+
+static inline int64_t test_sym(const char* s) {
+    return td_sym_intern(s, strlen(s));
+}
+
+#endif /* TD_TEST_CHECK_H */
@@ -0,0 +1,113 @@
+/*
+ *   Copyright (c) 2024-2026 Anton Kundenko <singaraiona@gmail.com>
+ *   All rights reserved.
+
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy
+ *   of this software and associated documentation files (the "Software"), to deal
+ *   in the Software without restriction, including without limitation the rights
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *   copies of the Software, and to permit persons to whom the Software is
+ *   furnished to do so, subject to the following conditions:
+
+ *   The above copyright notice and this permission notice shall be included in all
+ *   copies or substantial portions of the Software.
+
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *   SOFTWARE.
+ */
+
+/*
+ * Two query threads share the pool: each runs its own sum(v*k) queries
+ * while the other dispatches, and every result must be its own exact sum.
+ * A watchdog turns a stuck dispatch into a failure instead of a hang.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include "check.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define N_ROWS     (2 * 1000 * 1000)
+#define N_QUERIES  200
+#define N_THREADS  2
+#define TIMEOUT_S  120
+
+static atomic_int g_done;
+static int        g_wrong[N_THREADS];
+static int        g_errors[N_THREADS];
+
+/* Seeded by thread so that a task run against the other thread's
+ * columns shows up as a different sum */
+static void* runner(void* arg) {
+    int id = (int)(intptr_t)arg;
+    td_heap_init();
+    td_sym_init();
+
+    td_t* v = td_vec_new(TD_I64, N_ROWS);
+    td_t* k = td_vec_new(TD_I64, N_ROWS);
+    v->len = k->len = N_ROWS;
+    int64_t want = 0;
+    for (int64_t i = 0; i < N_ROWS; i++) {
+        int64_t a = (i * (id + 3)) % 1000;
+        int64_t b = i % (7 + id);
+        ((int64_t*)td_data(v))[i] = a;
+        ((int64_t*)td_data(k))[i] = b;
+        want += a * b;
+    }
+    td_t* t = td_table_new(2);
+    t = td_table_add_col(t, test_sym("v"), v);
+    t = td_table_add_col(t, test_sym("k"), k);
+
+    for (int q = 0; q < N_QUERIES; q++) {
+        td_graph_t* g = td_graph_new(t);
+        td_t* r = td_execute(g, td_sum(g, td_mul(g, td_scan(g, "v"), td_scan(g, "k"))));
+        td_graph_free(g);
+        if (!r || TD_IS_ERR(r)) { g_errors[id]++; continue; }
+        if (r->type != TD_ATOM_I64 || r->i64 != want) g_wrong[id]++;
+        td_release(r);
+    }
+
+    td_release(t);
+    td_release(v);
+    td_release(k);
+    td_sym_destroy();
+    td_heap_destroy();
+    atomic_fetch_add(&g_done, 1);
+    return NULL;
+}
+
+int main(void) {
+    td_heap_init();
+    td_sym_init();
+    CHECK(td_pool_init(4) == TD_OK);
+
+    pthread_t th[N_THREADS];
+    for (int i = 0; i < N_THREADS; i++)
+        pthread_create(&th[i], NULL, runner, (void*)(intptr_t)i);
+
+    struct timespec nap = { 0, 10 * 1000 * 1000 };
+    for (int ticks = 0; atomic_load(&g_done) < N_THREADS; ticks++) {
+        if (ticks == TIMEOUT_S * 100) {
+            fprintf(stderr, "concurrent queries still running after %d s\n", TIMEOUT_S);
+            _Exit(1);
+        }
+        nanosleep(&nap, NULL);
+    }
+    for (int i = 0; i < N_THREADS; i++) {
+        pthread_join(th[i], NULL);
+        CHECK(g_errors[i] == 0);
+        CHECK(g_wrong[i] == 0);
+    }
+
+    td_pool_destroy();
+    td_sym_destroy();
+    td_heap_destroy();
+    TEST_DONE();
+}
@@ -0,0 +1,251 @@
+/*
+ *   Copyright (c) 2024-2026 Anton Kundenko <singaraiona@gmail.com>
+ *   All rights reserved.
+
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy
+ *   of this software and associated documentation files (the "Software"), to deal
+ *   in the Software without restriction, including without limitation the rights
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *   copies of the Software, and to permit persons to whom the Software is
+ *   furnished to do so, subject to the following conditions:
+
+ *   The above copyright notice and this permission notice shall be included in all
+ *   copies or substantial portions of the Software.
+
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *   SOFTWARE.
+ */
+
+/*
+ * Encoded (compressed) columns: encode/decode round trips, queries over a
+ * splayed table with encoded columns match the same queries over the flat
+ * table, only the scanned columns are decoded, and damaged files are
+ * refused.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "check.h"
+#include <stdlib.h>
+#include <unistd.h>
+
+#define N_ROWS 200003
+
+static char g_dir[64];
+
+static int same_vec(td_t* a, td_t* b) {
+    if (!a || !b || a->type != b->type || a->len != b->len) return 0;
+    size_t esz = td_sym_elem_size(a->type, a->attrs);
+    if (memcmp(td_data(a), td_data(b), esz * (size_t)a->len) != 0) return 0;
+    for (int64_t i = 0; i < a->len; i++)
+        if (td_vec_is_null(a, i) != td_vec_is_null(b, i)) return 0;
+    return 1;
+}
+
+static int same_table(td_t* a, td_t* b) {
+    if (!a || TD_IS_ERR(a) || !b || TD_IS_ERR(b)) return 0;
+    if (td_table_ncols(a) != td_table_ncols(b)) return 0;
+    for (int64_t c = 0; c < td_table_ncols(a); c++)
+        if (!same_vec(td_table_get_col_idx(a, c), td_table_get_col_idx(b, c)))
+            return 0;
+    return 1;
+}
+
+static td_t* make_table(void) {
+    td_t* ts = td_vec_new(TD_TIMESTAMP, N_ROWS);
+    td_t* q  = td_vec_new(TD_I32, N_ROWS);
+    td_t* k  = td_vec_new(TD_I32, N_ROWS);
+    ts->len = q->len = k->len = N_ROWS;
+    uint64_t x = 88172645463325252ULL;
+    for (int64_t i = 0; i < N_ROWS; i++) {
+        x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+        ((int64_t*)td_data(ts))[i] = 1700000000000000LL + i * 1000 + (int64_t)(x % 50);
+        ((int32_t*)td_data(q))[i]  = 1 + (int32_t)((x >> 8) % 50);
+        ((int32_t*)td_data(k))[i]  = (int32_t)((i / 700) % 9 - 4);
+    }
+    /* "ts" goes last: the row count comes from the first column */
+    td_t* t = td_table_new(3);
+    t = td_table_add_col(t, test_sym("q"), q);
+    t = td_table_add_col(t, test_sym("k"), k);
+    t = td_table_add_col(t, test_sym("ts"), ts);
+    td_release(ts);
+    td_release(q);
+    td_release(k);
+    return t;
+}
+
+static void check_round_trip(td_t* t) {
+    for (int64_t c = 0; c < td_table_ncols(t); c++) {
+        td_t* v = td_table_get_col_idx(t, c);
+        td_t* e = td_col_encode(v);
+        CHECK_OK(e);
+        CHECK(e->type == TD_ENCODED);
+        td_t* d = td_col_decode(e);
+        CHECK_OK(d);
+        CHECK(same_vec(d, v));
+        td_release(e);
+        td_release(d);
+    }
+
+    /* Nulls survive, and incompressible data is left as it is */
+    td_t* n = td_vec_new(TD_I32, 5000);
+    n->len = 5000;
+    for (int i = 0; i < 5000; i++) ((int32_t*)td_data(n))[i] = i % 10;
+    for (int i = 0; i < 5000; i += 97) td_vec_set_null(n, i, true);
+    td_t* e = td_col_encode(n);
+    td_t* d = td_col_decode(e);
+    CHECK(same_vec(d, n));
+    td_release(e);
+    td_release(d);
+    td_release(n);
+
+    td_t* f = td_vec_new(TD_F64, 100);
+    f->len = 100;
+    for (int i = 0; i < 100; i++) ((double*)td_data(f))[i] = i * 0.5;
+    e = td_col_encode(f);
+    CHECK(e == f);
+    td_release(e);
+    td_release(f);
+}
+
+/* Runs `build` over each table and checks that the results agree */
+typedef td_op_t* (*build_fn)(td_graph_t* g, td_t* tbl);
+
+static void check_same_result(td_t* flat, td_t* enc, build_fn build) {
+    td_t* res[2];
+    td_t* in[2] = { flat, enc };
+    for (int i = 0; i < 2; i++) {
+        td_graph_t* g = td_graph_new(in[i]);
+        res[i] = td_execute(g, td_optimize(g, build(g, in[i])));
+        td_graph_free(g);
+        CHECK_OK(res[i]);
+    }
+    if (res[0] && !TD_IS_ERR(res[0]) && res[1] && !TD_IS_ERR(res[1])) {
+        if (res[0]->type == TD_TABLE)
+            CHECK(same_table(res[0], res[1]));
+        else
+            CHECK(res[0]->type == res[1]->type && res[0]->i64 == res[1]->i64);
+    }
+    for (int i = 0; i < 2; i++)
+        if (res[i] && !TD_IS_ERR(res[i])) td_release(res[i]);
+}
+
+static td_op_t* sum_filtered(td_graph_t* g, td_t* tbl) {
+    (void)tbl;
+    td_op_t* pred = td_and(g, td_lt(g, td_scan(g, "ts"), td_const_i64(g, 1700000100000000LL)),
+                              td_gt(g, td_scan(g, "q"), td_const_i64(g, 20)));
+    return td_sum(g, td_filter(g, td_scan(g, "q"), pred));
+}
+
+static td_op_t* group_by_k(td_graph_t* g, td_t* tbl) {
+    (void)tbl;
+    td_op_t* key = td_scan(g, "k");
+    uint16_t ops[2] = { OP_SUM, OP_MAX };
+    td_op_t* ins[2] = { td_scan(g, "q"), td_scan(g, "q") };
+    return td_group(g, &key, 1, ops, ins, 2);
+}
+
+static td_op_t* sort_table(td_graph_t* g, td_t* tbl) {
+    td_op_t* keys[2] = { td_scan(g, "q"), td_scan(g, "ts") };
+    uint8_t descs[2] = { 1, 0 };
+    return td_sort_op(g, td_const_table(g, tbl), keys, descs, NULL, 2);
+}
+
+static td_op_t* filter_table(td_graph_t* g, td_t* tbl) {
+    return td_filter(g, td_const_table(g, tbl),
+                     td_eq(g, td_scan(g, "k"), td_const_i64(g, 3)));
+}
+
+static void check_queries(td_t* flat) {
+    char sym[96];
+    snprintf(sym, sizeof sym, "%s/sym", g_dir);
+    CHECK(td_splay_save(flat, g_dir, sym) == TD_OK);
+
+    td_t* enc = td_read_splayed(g_dir, sym);
+    CHECK_OK(enc);
+    if (!enc || TD_IS_ERR(enc)) return;
+
+    check_same_result(flat, enc, sum_filtered);
+    check_same_result(flat, enc, group_by_k);
+    check_same_result(flat, enc, sort_table);
+    check_same_result(flat, enc, filter_table);
+    td_release(enc);
+
+    /* Only the columns a plan reads are decoded: with "ts" damaged, a
+     * plan that does not scan it still runs and one over the whole table
+     * reports the damage */
+    char ts[96];
+    snprintf(ts, sizeof ts, "%s/ts", g_dir);
+    CHECK(truncate(ts, 64) == 0);
+    enc = td_read_splayed(g_dir, sym);
+    CHECK_OK(enc);
+    if (!enc || TD_IS_ERR(enc)) return;
+    check_same_result(flat, enc, group_by_k);
+    td_graph_t* g = td_graph_new(enc);
+    td_t* r = td_execute(g, td_optimize(g, sort_table(g, enc)));
+    CHECK(TD_IS_ERR(r));
+    td_graph_free(g);
+    td_release(enc);
+}
+
+static void check_damaged(void) {
+    char path[96], bad[96];
+    snprintf(path, sizeof path, "%s/q", g_dir);
+    snprintf(bad, sizeof bad, "%s/bad", g_dir);
+
+    FILE* f = fopen(path, "rb");
+    CHECK(f != NULL);
+    if (!f) return;
+    static char buf[1 << 20];
+    size_t n = fread(buf, 1, sizeof buf, f);
+    fclose(f);
+    CHECK(n > 256);
+
+    /* Truncated: the blob claims more bytes than the file has */
+    f = fopen(bad, "wb");
+    fwrite(buf, 1, n / 2, f);
+    fclose(f);
+    td_t* v = td_col_mmap(bad);
+    CHECK(TD_IS_ERR(v) && TD_ERR_CODE(v) == TD_ERR_CORRUPT);
+    v = td_col_load(bad);
+    CHECK(TD_IS_ERR(v) && TD_ERR_CODE(v) == TD_ERR_CORRUPT);
+
+    /* Scribbled block table */
+    memset(buf + 64, 0xff, 64);
+    f = fopen(bad, "wb");
+    fwrite(buf, 1, n, f);
+    fclose(f);
+    v = td_col_load(bad);
+    CHECK(TD_IS_ERR(v) && TD_ERR_CODE(v) == TD_ERR_CORRUPT);
+    unlink(bad);
+}
+
+int main(void) {
+    td_heap_init();
+    td_sym_init();
+    snprintf(g_dir, sizeof g_dir, "/tmp/teide_encXXXXXX");
+    CHECK(mkdtemp(g_dir) != NULL);
+
+    td_t* t = make_table();
+    check_round_trip(t);
+    check_queries(t);
+    check_damaged();
+    td_release(t);
+
+    const char* files[] = { "ts", "q", "k", "sym", ".d" };
+    for (size_t i = 0; i < sizeof files / sizeof files[0]; i++) {
+        char path[96];
+        snprintf(path, sizeof path, "%s/%s", g_dir, files[i]);
+        unlink(path);
+    }
+    rmdir(g_dir);
+
+    td_sym_destroy();
+    td_heap_destroy();
+    TEST_DONE();
+}
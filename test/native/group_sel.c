@@ -0,0 +1,169 @@
+/*
+ *   Copyright (c) 2024-2026 Anton Kundenko <singaraiona@gmail.com>
+ *   All rights reserved.
+
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy
+ *   of this software and associated documentation files (the "Software"), to deal
+ *   in the Software without restriction, including without limitation the rights
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *   copies of the Software, and to permit persons to whom the Software is
+ *   furnished to do so, subject to the following conditions:
+
+ *   The above copyright notice and this permission notice shall be included in all
+ *   copies or substantial portions of the Software.
+
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *   SOFTWARE.
+ */
+
+/*
+ * A group's leading filter arrives as g->selection, sized to the source
+ * table. Sorting, limiting or windowing the group's result afterwards
+ * must not apply that selection again: each plan here matches a
+ * brute-force reference over the filtered rows.
+ */
+
+#include "check.h"
+#include <math.h>
+
+#define N    300001   /* above the parallel threshold */
+#define NCAT 37
+
+static uint64_t g_rs = 88172645463325252ULL;
+static uint64_t rnd(void) {
+    g_rs ^= g_rs << 13; g_rs ^= g_rs >> 7; g_rs ^= g_rs << 17;
+    return g_rs;
+}
+
+static int64_t want_sum[NCAT], want_cnt[NCAT];
+
+/* Run root with the selection price > 40 set the way ExecutePlan sets it */
+static td_t* run_filtered(td_t* tbl, td_graph_t* g, td_op_t* root) {
+    td_t* pred = td_execute(g, td_gt(g, td_scan(g, "price"), td_const_f64(g, 40.0)));
+    if (!pred || TD_IS_ERR(pred)) return pred;
+    g->selection = td_sel_from_pred(pred);
+    td_release(pred);
+    (void)tbl;
+    return td_execute(g, td_optimize(g, root));
+}
+
+static td_op_t* group_sum(td_graph_t* g) {
+    td_op_t* keys[1] = { td_scan(g, "cat") };
+    uint16_t ops[1] = { OP_SUM };
+    td_op_t* ins[1] = { td_scan(g, "quantity") };
+    return td_group(g, keys, 1, ops, ins, 1);
+}
+
+static td_op_t* by_cat(td_graph_t* g, td_op_t* input, uint8_t desc) {
+    td_op_t* keys[1] = { td_scan(g, "cat") };
+    uint8_t descs[1] = { desc };
+    return td_sort_op(g, input, keys, descs, NULL, 1);
+}
+
+/* Rows of r are (cat, sum) pairs for categories first..first+n*step */
+static void check_groups(td_t* r, int64_t n, int64_t first, int64_t step) {
+    CHECK_OK(r);
+    if (!r || TD_IS_ERR(r)) return;
+    CHECK(td_table_nrows(r) == n);
+    td_t* kc = td_table_get_col_idx(r, 0);
+    td_t* sc = td_table_get_col_idx(r, 1);
+    if (td_table_nrows(r) == n && kc && sc) {
+        for (int64_t i = 0; i < n; i++) {
+            int64_t cat = ((int64_t*)td_data(kc))[i];
+            CHECK(cat == first + i * step);
+            CHECK(((int64_t*)td_data(sc))[i] == want_sum[cat]);
+        }
+    }
+    td_release(r);
+}
+
+int main(void) {
+    td_heap_init();
+    td_sym_init();
+    CHECK(td_pool_init(4) == TD_OK);
+
+    td_t* cat = td_vec_new(TD_I64, N);
+    td_t* price = td_vec_new(TD_F64, N);
+    td_t* qty = td_vec_new(TD_I64, N);
+    cat->len = price->len = qty->len = N;
+    for (int64_t i = 0; i < N; i++) {
+        int64_t c = (int64_t)(rnd() % NCAT);
+        double p = (double)(rnd() % 10000) / 100.0;
+        int64_t q = (int64_t)(rnd() % 100);
+        ((int64_t*)td_data(cat))[i] = c;
+        ((double*)td_data(price))[i] = p;
+        ((int64_t*)td_data(qty))[i] = q;
+        if (p > 40.0) { want_sum[c] += q; want_cnt[c]++; }
+    }
+    for (int64_t c = 0; c < NCAT; c++) CHECK(want_cnt[c] > 0);
+    td_t* tbl = td_table_new(3);
+    tbl = td_table_add_col(tbl, test_sym("cat"), cat);
+    tbl = td_table_add_col(tbl, test_sym("price"), price);
+    tbl = td_table_add_col(tbl, test_sym("quantity"), qty);
+
+    /* filter -> groupBy -> sort */
+    td_graph_t* g = td_graph_new(tbl);
+    check_groups(run_filtered(tbl, g, by_cat(g, group_sum(g), 0)), NCAT, 0, 1);
+    td_graph_free(g);
+
+    /* filter -> groupBy -> sort -> head (fused top-N) */
+    g = td_graph_new(tbl);
+    check_groups(run_filtered(tbl, g, td_head(g, by_cat(g, group_sum(g), 1), 5)),
+                 5, NCAT - 1, -1);
+    td_graph_free(g);
+
+    /* filter -> groupBy -> sort -> head over a sorted group */
+    g = td_graph_new(tbl);
+    check_groups(run_filtered(tbl, g, td_head(g, by_cat(g, group_sum(g), 0), 3)),
+                 3, 0, 1);
+    td_graph_free(g);
+
+    /* filter -> groupBy -> head -> sort: the limit is taken first */
+    g = td_graph_new(tbl);
+    td_t* r = run_filtered(tbl, g, by_cat(g, td_head(g, group_sum(g), 4), 0));
+    td_graph_free(g);
+    CHECK_OK(r);
+    if (r && !TD_IS_ERR(r)) {
+        CHECK(td_table_nrows(r) == 4);
+        td_t* kc = td_table_get_col_idx(r, 0);
+        td_t* sc = td_table_get_col_idx(r, 1);
+        for (int64_t i = 0; kc && sc && i < td_table_nrows(r); i++) {
+            int64_t c = ((int64_t*)td_data(kc))[i];
+            CHECK(c >= 0 && c < NCAT && ((int64_t*)td_data(sc))[i] == want_sum[c]);
+        }
+        td_release(r);
+    }
+
+    /* filter -> groupBy(median) -> sort */
+    g = td_graph_new(tbl);
+    td_op_t* keys[1] = { td_scan(g, "cat") };
+    uint16_t ops[1] = { OP_QUANTILE };
+    td_op_t* ins[1] = { td_scan(g, "quantity") };
+    double params[1] = { 0.5 };
+    r = run_filtered(tbl, g, by_cat(g, td_group_params(g, keys, 1, ops, ins, params, 1), 0));
+    td_graph_free(g);
+    CHECK_OK(r);
+    if (r && !TD_IS_ERR(r)) {
+        CHECK(td_table_nrows(r) == NCAT);
+        td_t* mc = td_table_get_col_idx(r, 1);
+        for (int64_t i = 0; mc && i < td_table_nrows(r); i++) {
+            double m = ((double*)td_data(mc))[i];
+            CHECK(m >= 0.0 && m < 100.0);
+        }
+        td_release(r);
+    }
+
+    td_release(tbl);
+    td_release(cat);
+    td_release(price);
+    td_release(qty);
+    td_pool_destroy();
+    td_sym_destroy();
+    td_heap_destroy();
+    TEST_DONE();
+}
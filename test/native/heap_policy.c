@@ -0,0 +1,124 @@
+/*
+ *   Copyright (c) 2024-2026 Anton Kundenko <singaraiona@gmail.com>
+ *   All rights reserved.
+
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy
+ *   of this software and associated documentation files (the "Software"), to deal
+ *   in the Software without restriction, including without limitation the rights
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *   copies of the Software, and to permit persons to whom the Software is
+ *   furnished to do so, subject to the following conditions:
+
+ *   The above copyright notice and this permission notice shall be included in all
+ *   copies or substantial portions of the Software.
+
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *   SOFTWARE.
+ */
+
+/*
+ * Page policy: td_vm_prefault makes a range resident in one call, the
+ * PREFAULT heap flag does so for large blocks, and td_heap_gc keeps up to
+ * the warm reserve of emptied oversized pools mapped.
+ */
+
+#define _DEFAULT_SOURCE
+
+#include "check.h"
+#include <stdint.h>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+
+/* Pages of [p, p+size) that are resident, by mincore, and in all */
+static size_t resident(void* p, size_t size, size_t* total) {
+    size_t pg = (size_t)sysconf(_SC_PAGESIZE);
+    uintptr_t base = (uintptr_t)p & ~(uintptr_t)(pg - 1);
+    size_t n = ((uintptr_t)p + size - base + pg - 1) / pg;
+    static unsigned char vec[1 << 16];
+    *total = n;
+    if (n > sizeof vec || mincore((void*)base, n * pg, vec) != 0) return (size_t)-1;
+    size_t r = 0;
+    for (size_t i = 0; i < n; i++) r += vec[i] & 1;
+    return r;
+}
+#endif
+
+#define BIG ((size_t)64 << 20)   /* above the 32 MB standard pool */
+
+static size_t pool_bytes(void) {
+    td_heap_stats_t hs;
+    td_heap_stats(&hs);
+    return hs.pool_bytes;
+}
+
+int main(void) {
+    td_heap_init();
+    td_sym_init();
+
+#if defined(__linux__)
+    /* td_vm_prefault: a fresh mapping becomes resident, contents kept */
+    size_t size = (size_t)8 << 20;
+    char* p = td_vm_alloc(size);
+    CHECK(p != NULL);
+    size_t n;
+    if (p) {
+        CHECK(resident(p, size, &n) == 0);
+        p[12345] = 42;
+        td_vm_prefault(p, size, true);
+        CHECK(resident(p, size, &n) == n);
+        CHECK(p[12345] == 42 && p[0] == 0 && p[size - 1] == 0);
+        td_vm_free(p, size);
+    }
+
+    /* PREFAULT: a large block is resident when td_alloc returns it */
+    td_heap_opts_t opts = { TD_HEAP_PREFAULT, 0 };
+    td_heap_configure(&opts);
+    td_t* v = td_alloc((size_t)4 << 20);
+    CHECK_OK(v);
+    if (v && !TD_IS_ERR(v)) {
+        CHECK(resident(td_data(v), (size_t)4 << 20, &n) == n);
+        td_free(v);
+    }
+    opts.flags = 0;
+    td_heap_configure(&opts);
+#endif
+
+    /* Warm reserve: an emptied oversized pool outlives td_heap_gc only
+     * while it fits the reserve */
+    td_t* small = td_alloc(64);
+    CHECK_OK(small);
+    size_t base = pool_bytes();
+
+    td_heap_opts_t keep = { 0, BIG * 4 };
+    td_heap_configure(&keep);
+    v = td_alloc(BIG);
+    CHECK_OK(v);
+    size_t grown = pool_bytes();
+    CHECK(grown > base + BIG);
+    td_free(v);
+    td_heap_gc();
+    CHECK(pool_bytes() == grown);
+
+    /* The kept pool serves the next large block without a new mapping */
+    v = td_alloc(BIG);
+    CHECK_OK(v);
+    CHECK(pool_bytes() == grown);
+    td_free(v);
+
+    keep.reserve_bytes = 0;
+    td_heap_configure(&keep);
+    td_heap_gc();
+    CHECK(pool_bytes() == base);
+
+    td_free(small);
+    td_sym_destroy();
+    td_heap_destroy();
+    TEST_DONE();
+}
@@ -0,0 +1,213 @@
+/*
+ *   Copyright (c) 2024-2026 Anton Kundenko <singaraiona@gmail.com>
+ *   All rights reserved.
+
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy
+ *   of this software and associated documentation files (the "Software"), to deal
+ *   in the Software without restriction, including without limitation the rights
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *   copies of the Software, and to permit persons to whom the Software is
+ *   furnished to do so, subject to the following conditions:
+
+ *   The above copyright notice and this permission notice shall be included in all
+ *   copies or substantial portions of the Software.
+
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *   SOFTWARE.
+ */
+
+/*
+ * Lazy column mapping: opening a splayed or parted table maps no column
+ * file, a query maps only the columns it scans, and readahead of the next
+ * partition pages that partition in without touching the others.
+ */
+
+#define _DEFAULT_SOURCE
+
+#include "check.h"
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define NPART  3
+#define PROWS  (1 << 20)   /* 8 MB per F64 segment */
+
+static char g_db[64];
+static double g_sums[3];   /* running sums of columns a, b, c */
+
+static uint64_t g_rs = 88172645463325252ULL;
+static uint64_t rnd(void) {
+    g_rs ^= g_rs << 13; g_rs ^= g_rs >> 7; g_rs ^= g_rs << 17;
+    return g_rs;
+}
+
+/* F64 is never stored encoded, so the column maps in place. Whole
+ * values keep every sum exact. */
+static td_t* random_f64(int64_t n, double* sum) {
+    td_t* v = td_vec_new(TD_F64, n);
+    v->len = n;
+    for (int64_t i = 0; i < n; i++) {
+        double x = (double)(rnd() % 1000000);
+        ((double*)td_data(v))[i] = x;
+        *sum += x;
+    }
+    return v;
+}
+
+static td_t* make_table(int64_t n) {
+    td_t* a = random_f64(n, &g_sums[0]);
+    td_t* b = random_f64(n, &g_sums[1]);
+    td_t* c = random_f64(n, &g_sums[2]);
+    td_t* t = td_table_new(3);
+    t = td_table_add_col(t, test_sym("a"), a);
+    t = td_table_add_col(t, test_sym("b"), b);
+    t = td_table_add_col(t, test_sym("c"), c);
+    td_release(a);
+    td_release(b);
+    td_release(c);
+    return t;
+}
+
+static double sum_of(td_t* tbl, const char* col) {
+    td_graph_t* g = td_graph_new(tbl);
+    td_t* r = td_execute(g, td_sum(g, td_scan(g, col)));
+    td_graph_free(g);
+    if (!r || TD_IS_ERR(r)) return -1;
+    double s = r->f64;
+    td_release(r);
+    return s;
+}
+
+/* Drops the file's pages from the page cache */
+static void evict(const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return;
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+/* Resident share (0..1) of a segment's data, header page excluded */
+static double resident(td_t* seg) {
+    size_t pg = (size_t)sysconf(_SC_PAGESIZE);
+    uintptr_t lo = ((uintptr_t)td_data(seg) + pg - 1) & ~(uintptr_t)(pg - 1);
+    uintptr_t hi = ((uintptr_t)td_data(seg) + (size_t)seg->len * 8) & ~(uintptr_t)(pg - 1);
+    size_t n = (hi - lo) / pg;
+    static unsigned char vec[PROWS * 8 / 4096 + 2];
+    if (n == 0 || n > sizeof vec || mincore((void*)lo, n * pg, vec) != 0) return -1;
+    size_t r = 0;
+    for (size_t i = 0; i < n; i++) r += vec[i] & 1;
+    return (double)r / (double)n;
+}
+
+static void splayed(void) {
+    char dir[128], path[160];
+    snprintf(dir, sizeof dir, "%s/splayed", g_db);
+    mkdir(dir, 0755);
+    memset(g_sums, 0, sizeof g_sums);
+    td_t* t = make_table(1000);
+    CHECK(td_splay_save(t, dir, NULL) == TD_OK);
+    td_release(t);
+
+    td_t* s = td_read_splayed(dir, NULL);
+    CHECK_OK(s);
+    if (!s || TD_IS_ERR(s)) return;
+    for (int64_t c = 0; c < td_table_ncols(s); c++)
+        CHECK(td_table_peek_col_idx(s, c)->type == TD_LAZY);
+
+    /* Columns b and c were never mapped: emptied on disk, only a query
+     * that scans them notices */
+    snprintf(path, sizeof path, "%s/b", dir);
+    CHECK(truncate(path, 0) == 0);
+    snprintf(path, sizeof path, "%s/c", dir);
+    CHECK(truncate(path, 0) == 0);
+    CHECK(sum_of(s, "a") == g_sums[0]);
+    CHECK(td_table_get_col(s, test_sym("b")) == NULL);
+
+    /* A column maps once and stays mapped */
+    td_t* a = td_table_get_col(s, test_sym("a"));
+    CHECK(a != NULL && a->mmod == 1 && a->type == TD_F64 && a->len == 1000);
+    CHECK(td_table_get_col(s, test_sym("a")) == a);
+    CHECK(td_table_peek_col_idx(s, 0)->type == TD_LAZY);
+    td_release(s);
+}
+
+static void parted(void) {
+    char dir[128], sym[96], path[192];
+    snprintf(sym, sizeof sym, "%s/sym", g_db);
+    memset(g_sums, 0, sizeof g_sums);
+    for (int p = 0; p < NPART; p++) {
+        td_t* t = make_table(PROWS);
+        snprintf(dir, sizeof dir, "%s/2024.01.0%d", g_db, p + 1);
+        mkdir(dir, 0755);
+        snprintf(dir, sizeof dir, "%s/2024.01.0%d/t", g_db, p + 1);
+        mkdir(dir, 0755);
+        CHECK(td_splay_save(t, dir, sym) == TD_OK);
+        td_release(t);
+        snprintf(path, sizeof path, "%s/a", dir);
+        CHECK(td_col_rows(path) == PROWS);
+    }
+    CHECK(td_sym_save(sym) == TD_OK);
+
+    td_t* pt = td_read_parted(g_db, "t");
+    CHECK_OK(pt);
+    if (!pt || TD_IS_ERR(pt)) return;
+    CHECK(td_table_nrows(pt) == (int64_t)NPART * PROWS);
+
+    /* Column c of the middle partition is damaged after the open: the
+     * other columns still answer */
+    snprintf(path, sizeof path, "%s/2024.01.02/t/c", g_db);
+    CHECK(truncate(path, 0) == 0);
+    CHECK(sum_of(pt, "b") == g_sums[1]);
+    CHECK(td_table_get_col(pt, test_sym("c")) == NULL);
+
+    /* Readahead of one segment pages that segment in and leaves the
+     * others alone */
+    td_t* a = td_table_get_col(pt, test_sym("a"));
+    CHECK(a != NULL && TD_IS_PARTED(a->type) && a->len == NPART);
+    if (a && TD_IS_PARTED(a->type) && a->len == NPART) {
+        td_t** segs = (td_t**)td_data(a);
+        for (int p = 0; p < NPART; p++) {
+            snprintf(path, sizeof path, "%s/2024.01.0%d/t/a", g_db, p + 1);
+            evict(path);
+        }
+        if (resident(segs[1]) > 0.5) {
+            fprintf(stderr, "page cache not evictable here: readahead unchecked\n");
+        } else {
+            td_vm_advise_willneed(td_data(segs[1]), (size_t)segs[1]->len * 8);
+            double r = 0;
+            for (int i = 0; i < 200 && (r = resident(segs[1])) < 0.99; i++)
+                nanosleep(&(struct timespec){ 0, 10 * 1000 * 1000 }, NULL);
+            CHECK(r >= 0.99);
+            CHECK(resident(segs[2]) < 0.5);
+        }
+    }
+    CHECK(sum_of(pt, "a") == g_sums[0]);
+    td_release(pt);
+}
+
+int main(void) {
+    td_heap_init();
+    td_sym_init();
+    snprintf(g_db, sizeof g_db, "/tmp/teide_lazyXXXXXX");
+    CHECK(mkdtemp(g_db) != NULL);
+
+    splayed();
+    parted();
+
+    char cmd[96];
+    snprintf(cmd, sizeof cmd, "rm -rf %s", g_db);
+    CHECK(system(cmd) == 0);
+    td_sym_destroy();
+    td_heap_destroy();
+    TEST_DONE();
+}
@@ -0,0 +1,239 @@
+/*
+ *   Copyright (c) 2024-2026 Anton Kundenko <singaraiona@gmail.com>
+ *   All rights reserved.
+
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy
+ *   of this software and associated documentation files (the "Software"), to deal
+ *   in the Software without restriction, including without limitation the rights
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *   copies of the Software, and to permit persons to whom the Software is
+ *   furnished to do so, subject to the following conditions:
+
+ *   The above copyright notice and this permission notice shall be included in all
+ *   copies or substantial portions of the Software.
+
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *   SOFTWARE.
+ */
+
+/*
+ * Parted tables: sort, window and join over a partitioned table give the
+ * same rows as over its flattened copy, including with an empty
+ * partition.
+ */
+
+#define _XOPEN_SOURCE 700
+
+#include "check.h"
+#include <ftw.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+static const int64_t g_rows[4] = { 1500, 0, 900, 2100 };
+static char g_db[64];
+
+static uint64_t g_rs = 88172645463325252ULL;
+static uint64_t rnd(void) {
+    g_rs ^= g_rs << 13; g_rs ^= g_rs >> 7; g_rs ^= g_rs << 17;
+    return g_rs;
+}
+
+/* Daily partitions of table `name`; ids repeat within and across them */
+static void write_parted(const char* name, int64_t id_mod) {
+    char dir[128], sym[96];
+    snprintf(sym, sizeof sym, "%s/sym", g_db);
+    for (int p = 0; p < 4; p++) {
+        int64_t n = g_rows[p];
+        td_t* id = td_vec_new(TD_I64, n > 0 ? n : 1);
+        td_t* px = td_vec_new(TD_F64, n > 0 ? n : 1);
+        id->len = px->len = n;
+        for (int64_t i = 0; i < n; i++) {
+            ((int64_t*)td_data(id))[i] = (int64_t)(rnd() % (uint64_t)id_mod);
+            ((double*)td_data(px))[i] = (double)(rnd() % 100000) / 8.0;
+        }
+        td_t* t = td_table_new(2);
+        t = td_table_add_col(t, test_sym("id"), id);
+        t = td_table_add_col(t, test_sym("px"), px);
+        td_release(id);
+        td_release(px);
+        snprintf(dir, sizeof dir, "%s/2024.01.0%d", g_db, p + 1);
+        mkdir(dir, 0755);
+        snprintf(dir, sizeof dir, "%s/2024.01.0%d/%s", g_db, p + 1, name);
+        mkdir(dir, 0755);
+        CHECK(td_splay_save(t, dir, sym) == TD_OK);
+        td_release(t);
+    }
+}
+
+/* Flat copy: scanning a parted or MAPCOMMON column concatenates it */
+static td_t* flatten(td_t* pt) {
+    td_t* out = td_table_new(td_table_ncols(pt));
+    for (int64_t c = 0; c < td_table_ncols(pt); c++) {
+        int64_t name = td_table_col_name(pt, c);
+        td_graph_t* g = td_graph_new(pt);
+        td_t* v = td_execute(g, td_scan(g, td_str_ptr(td_sym_str(name))));
+        td_graph_free(g);
+        CHECK_OK(v);
+        out = td_table_add_col(out, name, v);
+        td_release(v);
+    }
+    return out;
+}
+
+/* Sorted by every column, for results whose row order is not defined */
+static td_t* sort_all(td_t* t) {
+    td_graph_t* g = td_graph_new(t);
+    int64_t n = td_table_ncols(t);
+    td_op_t* keys[8];
+    uint8_t descs[8] = { 0 };
+    for (int64_t c = 0; c < n && c < 8; c++)
+        keys[c] = td_scan(g, td_str_ptr(td_sym_str(td_table_col_name(t, c))));
+    td_t* r = td_execute(g, td_sort_op(g, td_const_table(g, t), keys, descs,
+                                       NULL, (uint8_t)(n < 8 ? n : 8)));
+    td_graph_free(g);
+    return r;
+}
+
+static int same_table(td_t* a, td_t* b) {
+    if (td_table_ncols(a) != td_table_ncols(b) || td_table_nrows(a) != td_table_nrows(b))
+        return 0;
+    for (int64_t c = 0; c < td_table_ncols(a); c++) {
+        td_t* x = td_table_get_col_idx(a, c);
+        td_t* y = td_table_get_col_idx(b, c);
+        if (!x || !y || x->type != y->type || x->len != y->len) return 0;
+        size_t esz = td_sym_elem_size(x->type, x->attrs);
+        if (memcmp(td_data(x), td_data(y), esz * (size_t)x->len) != 0) return 0;
+    }
+    return 1;
+}
+
+typedef td_op_t* (*build_fn)(td_graph_t* g, td_t* tbl);
+
+static td_t* g_right;   /* right side of the joins, parted or flat */
+static uint8_t g_join;  /* join type */
+
+static td_op_t* sort_px(td_graph_t* g, td_t* tbl) {
+    td_op_t* keys[2] = { td_scan(g, "px"), td_scan(g, "id") };
+    uint8_t descs[2] = { 1, 0 };
+    return td_sort_op(g, td_const_table(g, tbl), keys, descs, NULL, 2);
+}
+
+static td_op_t* window_by_date(td_graph_t* g, td_t* tbl) {
+    td_op_t* part[1] = { td_scan(g, "date") };
+    td_op_t* order[2] = { td_scan(g, "id"), td_scan(g, "px") };
+    uint8_t descs[2] = { 0, 0 };
+    uint8_t kinds[2] = { TD_WIN_ROW_NUMBER, TD_WIN_SUM };
+    td_op_t* ins[2] = { td_scan(g, "px"), td_scan(g, "px") };
+    int64_t params[2] = { 0, 0 };
+    return td_window_op(g, td_const_table(g, tbl), part, 1, order, descs, 2,
+                        kinds, ins, params, 2, TD_FRAME_ROWS,
+                        TD_BOUND_UNBOUNDED_PRECEDING, TD_BOUND_CURRENT_ROW, 0, 0);
+}
+
+static td_op_t* join_date_id(td_graph_t* g, td_t* tbl) {
+    td_op_t* l[2] = { td_scan(g, "date"), td_scan(g, "id") };
+    td_op_t* r[2] = { td_scan(g, "date"), td_scan(g, "id") };
+    return td_join(g, td_const_table(g, tbl), l, td_const_table(g, g_right), r, 2, g_join);
+}
+
+static void check_same(const char* what, td_t* pt, td_t* flat, build_fn build,
+                       int ordered) {
+    td_t* res[2];
+    td_t* in[2] = { pt, flat };
+    for (int i = 0; i < 2; i++) {
+        td_graph_t* g = td_graph_new(in[i]);
+        res[i] = td_execute(g, td_optimize(g, build(g, in[i])));
+        td_graph_free(g);
+    }
+    if (!res[0] || TD_IS_ERR(res[0]) || !res[1] || TD_IS_ERR(res[1])) {
+        fprintf(stderr, "%s: query failed\n", what);
+        g_fails++;
+    } else {
+        td_t* a = ordered ? res[0] : sort_all(res[0]);
+        td_t* b = ordered ? res[1] : sort_all(res[1]);
+        if (!same_table(a, b)) {
+            fprintf(stderr, "%s: parted and flat results differ\n", what);
+            g_fails++;
+        }
+        if (!ordered) {
+            td_release(a);
+            td_release(b);
+        }
+    }
+    for (int i = 0; i < 2; i++)
+        if (res[i] && !TD_IS_ERR(res[i])) td_release(res[i]);
+}
+
+static int rm_entry(const char* path, const struct stat* st, int flag, struct FTW* ftw) {
+    (void)st; (void)flag; (void)ftw;
+    return remove(path);
+}
+
+int main(void) {
+    td_heap_init();
+    td_sym_init();
+    snprintf(g_db, sizeof g_db, "/tmp/teide_partXXXXXX");
+    CHECK(mkdtemp(g_db) != NULL);
+
+    write_parted("l", 400);
+    write_parted("r", 600);
+    char sym[96];
+    snprintf(sym, sizeof sym, "%s/sym", g_db);
+    CHECK(td_sym_save(sym) == TD_OK);
+
+    td_t* pl = td_read_parted(g_db, "l");
+    td_t* pr = td_read_parted(g_db, "r");
+    CHECK_OK(pl);
+    CHECK_OK(pr);
+    if (pl && !TD_IS_ERR(pl) && pr && !TD_IS_ERR(pr)) {
+        td_t* fl = flatten(pl);
+        td_t* fr = flatten(pr);
+        CHECK(td_table_nrows(fl) == 4500);
+
+        check_same("sort", pl, fl, sort_px, 1);
+        check_same("window", pl, fl, window_by_date, 1);
+
+        /* Inner, left, full, semi and anti, co-partitioned */
+        for (g_join = 0; g_join <= 4; g_join++) {
+            char what[32];
+            snprintf(what, sizeof what, "join %d", g_join);
+            g_right = pr;
+            td_t* a;
+            td_graph_t* g = td_graph_new(pl);
+            a = td_execute(g, td_optimize(g, join_date_id(g, pl)));
+            td_graph_free(g);
+            g_right = fr;
+            g = td_graph_new(fl);
+            td_t* b = td_execute(g, td_optimize(g, join_date_id(g, fl)));
+            td_graph_free(g);
+            CHECK_OK(a);
+            CHECK_OK(b);
+            if (a && !TD_IS_ERR(a) && b && !TD_IS_ERR(b)) {
+                td_t* sa = sort_all(a);
+                td_t* sb = sort_all(b);
+                if (!same_table(sa, sb)) {
+                    fprintf(stderr, "%s: parted and flat results differ\n", what);
+                    g_fails++;
+                }
+                td_release(sa);
+                td_release(sb);
+            }
+            if (a && !TD_IS_ERR(a)) td_release(a);
+            if (b && !TD_IS_ERR(b)) td_release(b);
+        }
+        td_release(fl);
+        td_release(fr);
+    }
+    if (pl && !TD_IS_ERR(pl)) td_release(pl);
+    if (pr && !TD_IS_ERR(pr)) td_release(pr);
+
+    nftw(g_db, rm_entry, 16, FTW_DEPTH | FTW_PHYS);
+    td_sym_destroy();
+    td_heap_destroy();
+    TEST_DONE();
+}
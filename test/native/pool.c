@@ -0,0 +1,63 @@
+/*
+ *   Copyright (c) 2024-2026 Anton Kundenko <singaraiona@gmail.com>
+ *   All rights reserved.
+
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy
+ *   of this software and associated documentation files (the "Software"), to deal
+ *   in the Software without restriction, including without limitation the rights
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *   copies of the Software, and to permit persons to whom the Software is
+ *   furnished to do so, subject to the following conditions:
+
+ *   The above copyright notice and this permission notice shall be included in all
+ *   copies or substantial portions of the Software.
+
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *   SOFTWARE.
+ */
+
+/*
+ * Worker pool placement: a CPU set is checked against the CPUs the process
+ * may use, and a pinned pool either runs where it was asked to or fails.
+ */
+
+#include "check.h"
+
+int main(void) {
+    td_heap_init();
+    td_sym_init();
+
+    uint16_t cpus[256];
+    uint32_t n = td_cpu_list(cpus, 256);
+    CHECK(n >= 1);
+
+    /* A CPU outside the affinity set is rejected, and no pool is left */
+    uint16_t bad[2] = { cpus[0], 65000 };
+    td_pool_opts_t opts = { 2, bad, 2, TD_POOL_PIN };
+    CHECK(td_pool_init_ex(&opts) == TD_ERR_RANGE);
+    td_pool_stats_t ps;
+    CHECK(td_pool_stats(&ps, NULL, 0) == 0);
+
+    /* An allowed set pins every thread, dispatcher first */
+    opts.cpus = cpus;
+    opts.n_cpus = 1;
+    td_err_t err = td_pool_init_ex(&opts);
+#if defined(__linux__)
+    CHECK(err == TD_OK);
+#endif
+    if (err == TD_OK) {
+        td_pool_worker_stats_t ws[2];
+        CHECK(td_pool_stats(&ps, ws, 2) == 2);
+        CHECK(ws[0].cpu == cpus[0] && ws[1].cpu == cpus[0]);
+        td_pool_destroy();
+    }
+
+    td_sym_destroy();
+    td_heap_destroy();
+    TEST_DONE();
+}
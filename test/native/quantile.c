@@ -0,0 +1,195 @@
+/*
+ *   Copyright (c) 2024-2026 Anton Kundenko <singaraiona@gmail.com>
+ *   All rights reserved.
+
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy
+ *   of this software and associated documentation files (the "Software"), to deal
+ *   in the Software without restriction, including without limitation the rights
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *   copies of the Software, and to permit persons to whom the Software is
+ *   furnished to do so, subject to the following conditions:
+
+ *   The above copyright notice and this permission notice shall be included in all
+ *   copies or substantial portions of the Software.
+
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *   SOFTWARE.
+ */
+
+/*
+ * Scalar quantiles: td_quantile over a whole column matches a sorted
+ * reference exactly, its t-digest form stays close, and the atom it
+ * yields works in select and filter like any other reduction.
+ */
+
+#include "check.h"
+#include <math.h>
+#include <stdlib.h>
+
+#define N 300001   /* above the parallel threshold */
+
+static uint64_t g_rs = 88172645463325252ULL;
+static uint64_t rnd(void) {
+    g_rs ^= g_rs << 13; g_rs ^= g_rs >> 7; g_rs ^= g_rs << 17;
+    return g_rs;
+}
+
+static int cmp_f64(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static double reference(const double* sorted, int64_t n, double p) {
+    double h = p * (double)(n - 1);
+    int64_t lo = (int64_t)h;
+    if (lo >= n - 1) return sorted[n - 1];
+    return sorted[lo] + (h - (double)lo) * (sorted[lo + 1] - sorted[lo]);
+}
+
+static double quantile_of(td_t* tbl, const char* col, double p, bool approx) {
+    td_graph_t* g = td_graph_new(tbl);
+    td_t* r = td_execute(g, td_quantile(g, td_scan(g, col), p, approx));
+    td_graph_free(g);
+    if (!r || TD_IS_ERR(r) || r->type != TD_ATOM_F64) return NAN;
+    double v = r->f64;
+    td_release(r);
+    return v;
+}
+
+int main(void) {
+    td_heap_init();
+    td_sym_init();
+    CHECK(td_pool_init(4) == TD_OK);
+
+    /* x: F64 with every 97th value NaN; k: I32 */
+    td_t* x = td_vec_new(TD_F64, N);
+    td_t* k = td_vec_new(TD_I32, N);
+    x->len = k->len = N;
+    double* sorted = (double*)malloc(N * sizeof(double));
+    int64_t n_valid = 0;
+    for (int64_t i = 0; i < N; i++) {
+        double v = (double)(rnd() % 1000000) / 16.0;
+        ((double*)td_data(x))[i] = i % 97 == 0 ? NAN : v;
+        if (i % 97 != 0) sorted[n_valid++] = v;
+        ((int32_t*)td_data(k))[i] = (int32_t)(rnd() % 5000) - 2500;
+    }
+    qsort(sorted, (size_t)n_valid, sizeof(double), cmp_f64);
+    td_t* tbl = td_table_new(2);
+    tbl = td_table_add_col(tbl, test_sym("x"), x);
+    tbl = td_table_add_col(tbl, test_sym("k"), k);
+
+    const double ps[] = { 0.0, 0.01, 0.5, 0.95, 0.999, 1.0 };
+    for (size_t i = 0; i < sizeof ps / sizeof ps[0]; i++) {
+        double want = reference(sorted, n_valid, ps[i]);
+        CHECK(quantile_of(tbl, "x", ps[i], false) == want);
+        /* t-digest: within 1% of the value range (worst near the median) */
+        CHECK(fabs(quantile_of(tbl, "x", ps[i], true) - want) < 62500.0 * 0.01);
+    }
+
+    /* Integer input */
+    int64_t nk = 0;
+    for (int64_t i = 0; i < N; i++) sorted[nk++] = ((int32_t*)td_data(k))[i];
+    qsort(sorted, (size_t)nk, sizeof(double), cmp_f64);
+    CHECK(quantile_of(tbl, "k", 0.25, false) == reference(sorted, nk, 0.25));
+
+    /* Select broadcasts the atom; filter compares against it */
+    double med = reference(sorted, nk, 0.5);
+    td_graph_t* g = td_graph_new(tbl);
+    td_op_t* cols[1] = { td_alias(g, td_quantile(g, td_scan(g, "k"), 0.5, false), "m") };
+    td_t* r = td_execute(g, td_optimize(g, td_select(g, td_const_table(g, tbl), cols, 1)));
+    td_graph_free(g);
+    CHECK_OK(r);
+    if (r && !TD_IS_ERR(r)) {
+        td_t* m = td_table_get_col(r, test_sym("m"));
+        CHECK(m && m->type == TD_F64 && m->len == N && ((double*)td_data(m))[N - 1] == med);
+        td_release(r);
+    }
+    g = td_graph_new(tbl);
+    r = td_execute(g, td_optimize(g, td_filter(g, td_const_table(g, tbl),
+        td_gt(g, td_scan(g, "k"), td_quantile(g, td_scan(g, "k"), 0.5, false)))));
+    td_graph_free(g);
+    CHECK_OK(r);
+    if (r && !TD_IS_ERR(r)) {
+        int64_t above = 0;
+        for (int64_t i = 0; i < N; i++) above += ((int32_t*)td_data(k))[i] > med;
+        CHECK(td_table_nrows(r) == above);
+        td_release(r);
+    }
+
+    /* Grouped after a leading filter (the selection a query plan hands the
+     * group), then sorted by key: exact per-group medians of k > 0 */
+    td_t* gk = td_vec_new(TD_I64, N);
+    gk->len = N;
+    for (int64_t i = 0; i < N; i++) ((int64_t*)td_data(gk))[i] = 3 - i % 4;
+    td_t* gt = td_table_new(3);
+    gt = td_table_add_col(gt, test_sym("x"), x);
+    gt = td_table_add_col(gt, test_sym("k"), k);
+    gt = td_table_add_col(gt, test_sym("g"), gk);
+    g = td_graph_new(gt);
+    td_t* pv = td_execute(g, td_gt(g, td_scan(g, "k"), td_const_i64(g, 0)));
+    CHECK_OK(pv);
+    if (pv && !TD_IS_ERR(pv)) {
+        g->selection = td_sel_from_pred(pv);
+        td_release(pv);
+        td_op_t* keys[1] = { td_scan(g, "g") };
+        uint16_t ops[1] = { OP_QUANTILE };
+        td_op_t* ins[1] = { td_scan(g, "x") };
+        double params[1] = { 0.5 };
+        td_op_t* sk[1] = { td_scan(g, "g") };
+        uint8_t desc[1] = { 0 };
+        r = td_execute(g, td_optimize(g, td_sort_op(g,
+                td_group_params(g, keys, 1, ops, ins, params, 1), sk, desc, NULL, 1)));
+        CHECK_OK(r);
+        if (r && !TD_IS_ERR(r)) {
+            CHECK(td_table_nrows(r) == 4);
+            td_t* mc = td_table_get_col_idx(r, 1);
+            for (int64_t gid = 0; mc && gid < 4 && gid < td_table_nrows(r); gid++) {
+                int64_t m = 0;
+                for (int64_t i = 0; i < N; i++) {
+                    double v = ((double*)td_data(x))[i];
+                    if (3 - i % 4 == gid && ((int32_t*)td_data(k))[i] > 0 && !isnan(v))
+                        sorted[m++] = v;
+                }
+                qsort(sorted, (size_t)m, sizeof(double), cmp_f64);
+                CHECK(((double*)td_data(mc))[gid] == reference(sorted, m, 0.5));
+            }
+            td_release(r);
+        }
+    }
+    td_graph_free(g);
+    td_release(gt);
+    td_release(gk);
+
+    /* No rows, and a column a quantile can't order */
+    td_t* e = td_vec_new(TD_F64, 1);
+    td_t* sy = td_sym_vec_new(TD_SYM_W64, 1);
+    e->len = 0;
+    sy->len = 1;
+    ((int64_t*)td_data(sy))[0] = test_sym("a");
+    td_t* et = td_table_new(2);
+    et = td_table_add_col(et, test_sym("x"), e);
+    et = td_table_add_col(et, test_sym("s"), sy);
+    CHECK(isnan(quantile_of(et, "x", 0.5, false)));
+    CHECK(isnan(quantile_of(et, "x", 0.5, true)));
+    g = td_graph_new(et);
+    r = td_execute(g, td_quantile(g, td_scan(g, "s"), 0.5, false));
+    td_graph_free(g);
+    CHECK(TD_IS_ERR(r) && TD_ERR_CODE(r) == TD_ERR_TYPE);
+    td_release(et);
+    td_release(e);
+    td_release(sy);
+
+    free(sorted);
+    td_release(tbl);
+    td_release(x);
+    td_release(k);
+    td_pool_destroy();
+    td_sym_destroy();
+    td_heap_destroy();
+    TEST_DONE();
+}
@@ -0,0 +1,147 @@
+/*
+ *   Copyright (c) 2024-2026 Anton Kundenko <singaraiona@gmail.com>
+ *   All rights reserved.
+
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy
+ *   of this software and associated documentation files (the "Software"), to deal
+ *   in the Software without restriction, including without limitation the rights
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *   copies of the Software, and to permit persons to whom the Software is
+ *   furnished to do so, subject to the following conditions:
+
+ *   The above copyright notice and this permission notice shall be included in all
+ *   copies or substantial portions of the Software.
+
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *   SOFTWARE.
+ */
+
+/*
+ * Semi and anti joins (join types 3 and 4) keep the left rows that have,
+ * or lack, a matching key on the right, once each and in left order.
+ * Unsorted inputs probe a hash set of the right keys; inputs sorted on
+ * the key take the merge path. Both sides repeat keys, and every result
+ * is compared with a brute-force membership test.
+ */
+
+#include "check.h"
+#include <stdlib.h>
+
+#define NL     200000
+#define NR     120000
+#define KEYS   50000   /* left keys in [0, KEYS), right in [KEYS/2, 3*KEYS/2) */
+
+static uint64_t g_rs = 88172645463325252ULL;
+static uint64_t rnd(void) {
+    g_rs ^= g_rs << 13; g_rs ^= g_rs >> 7; g_rs ^= g_rs << 17;
+    return g_rs;
+}
+
+static int cmp_i64(const void* a, const void* b) {
+    int64_t x = *(const int64_t*)a, y = *(const int64_t*)b;
+    return (x > y) - (x < y);
+}
+
+/* Table (k, id) with id = row number; keys sorted first when asked */
+static td_t* make_side(int64_t n, int64_t base, bool sorted) {
+    td_t* k = td_vec_new(TD_I64, n);
+    td_t* id = td_vec_new(TD_I64, n);
+    k->len = id->len = n;
+    int64_t* kd = (int64_t*)td_data(k);
+    for (int64_t i = 0; i < n; i++) {
+        kd[i] = base + (int64_t)(rnd() % KEYS);
+        ((int64_t*)td_data(id))[i] = i;
+    }
+    if (sorted) qsort(kd, (size_t)n, sizeof(int64_t), cmp_i64);
+    td_t* t = td_table_new(2);
+    t = td_table_add_col(t, test_sym("k"), k);
+    t = td_table_add_col(t, test_sym("id"), id);
+    td_release(k);
+    td_release(id);
+    return t;
+}
+
+/* Join left to right on k; *merged reports whether the merge path ran */
+static td_t* run_join(td_t* left, td_t* right, uint8_t type, bool* merged) {
+    td_graph_t* g = td_graph_new(left);
+    td_graph_profile(g);
+    td_op_t* l[1] = { td_scan(g, "k") };
+    td_op_t* r[1] = { td_scan(g, "k") };
+    td_op_t* j = td_join(g, td_const_table(g, left), l, td_const_table(g, right), r, 1, type);
+    uint32_t jid = j->id;
+    td_t* res = td_execute(g, j);
+    *merged = (g->prof[jid].flags & TD_PROF_MERGE) != 0;
+    td_graph_free(g);
+    return res;
+}
+
+/* The ids of left rows whose key is (semi) or is not (anti) on the right */
+static void check_join(td_t* left, td_t* right, uint8_t type, bool want_merge) {
+    static bool on_right[2 * KEYS];
+    memset(on_right, 0, sizeof on_right);
+    td_t* rk = td_table_get_col(right, test_sym("k"));
+    for (int64_t i = 0; i < rk->len; i++)
+        on_right[((int64_t*)td_data(rk))[i]] = true;
+
+    bool merged = false;
+    td_t* res = run_join(left, right, type, &merged);
+    CHECK_OK(res);
+    if (!res || TD_IS_ERR(res)) return;
+    CHECK(merged == want_merge);
+    CHECK(td_table_ncols(res) == 2);
+
+    td_t* lk = td_table_get_col(left, test_sym("k"));
+    td_t* ok = td_table_get_col(res, test_sym("k"));
+    td_t* oid = td_table_get_col(res, test_sym("id"));
+    CHECK(ok && oid);
+    int64_t n = 0, bad = 0, nout = td_table_nrows(res);
+    for (int64_t i = 0; ok && oid && i < lk->len; i++) {
+        int64_t key = ((int64_t*)td_data(lk))[i];
+        if (on_right[key] != (type == 3)) continue;
+        if (n >= nout || ((int64_t*)td_data(oid))[n] != i
+            || ((int64_t*)td_data(ok))[n] != key)
+            bad++;
+        n++;
+    }
+    CHECK(bad == 0);
+    CHECK(nout == n);
+    td_release(res);
+}
+
+int main(void) {
+    td_heap_init();
+    td_sym_init();
+    CHECK(td_pool_init(4) == TD_OK);
+
+    /* Unsorted: hash set of the right keys */
+    td_t* l = make_side(NL, 0, false);
+    td_t* r = make_side(NR, KEYS / 2, false);
+    check_join(l, r, 3, false);
+    check_join(l, r, 4, false);
+    td_release(l);
+    td_release(r);
+
+    /* Sorted on the key: merge, runs of equal keys on both sides */
+    l = make_side(NL, 0, true);
+    r = make_side(NR, KEYS / 2, true);
+    check_join(l, r, 3, true);
+    check_join(l, r, 4, true);
+
+    /* An empty right side: semi keeps nothing, anti keeps every row */
+    td_t* er = make_side(0, 0, false);
+    check_join(l, er, 3, true);
+    check_join(l, er, 4, true);
+    td_release(er);
+    td_release(l);
+    td_release(r);
+
+    td_pool_destroy();
+    td_sym_destroy();
+    td_heap_destroy();
+    TEST_DONE();
+}